@@ -0,0 +1,476 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+
+#include "ads1115_lib.h"
+#include "ads1115_model.h"
+#include "ads1115_tsfile.h"
+
+// Streaming acquisition from one or more chips to a file. Every device
+// streams the same channels at the same DR; samples are written as CSV or as
+// compact binary records through one large write buffer, or as a
+// time-indexed ads1115_tsfile.h file. The loop polls the
+// driver devices so one thread keeps up with several chips, reports the
+// achieved rate and drops per device once a second on stderr and stops
+// cleanly on SIGINT/SIGTERM, flushing what it has.
+//
+// Binary output (host byte order): one struct acquire_header, then one
+// struct acquire_record per sample in the order they were read.
+
+#define ACQUIRE_MAX_DEVICES 8
+#define ACQUIRE_CHUNK       512          // Samples per read() from one device
+#define ACQUIRE_BUF_DEFAULT (1 << 20)    // Write buffer, bytes
+#define ACQUIRE_CSV_LINE    64           // Longest CSV line, bytes
+#define ACQUIRE_MAGIC       "ADS1115R"
+
+enum { ACQUIRE_BIN, ACQUIRE_CSV, ACQUIRE_TS };
+
+static const char *const format_names[] = { "bin", "csv", "ts" };
+
+struct acquire_header {
+    char magic[8];          // ACQUIRE_MAGIC, not NUL-terminated
+    uint32_t version;       // 1
+    uint32_t record_size;   // sizeof(struct acquire_record)
+    uint32_t num_devices;   // Devices in command line order
+    uint32_t channel_mask;  // Channels streamed on every device
+    uint32_t data_rate;     // DR code
+    uint32_t reserved;
+};
+
+struct acquire_record {
+    uint64_t timestamp_ns;  // CLOCK_MONOTONIC time the result was read
+    int16_t value;          // Raw conversion result
+    uint8_t device;         // Index into the command line devices
+    uint8_t channel;        // AIN index
+    uint8_t flags;          // ADS1115_SAMPLE_* bits
+    uint8_t reserved;
+    uint16_t seq;           // Per-device stream sequence number
+};
+
+_Static_assert(sizeof(struct acquire_header) == 32, "acquire_header layout");
+_Static_assert(sizeof(struct acquire_record) == 16, "acquire_record layout");
+
+struct acquire_dev {
+    struct ads1115_dev *dev;
+    struct ads1115_model model;  // Software chip behind -m
+    const char *name;
+    int poll_fd;                 // -1 for backends that convert in read()
+    int started;
+    int seen;                    // A sample arrived, seq is valid
+    uint16_t next_seq;
+    unsigned long long samples;  // Total written
+    unsigned long long drops;    // Sequence gaps
+    unsigned long long gaps;     // Samples flagged ADS1115_SAMPLE_GAP
+    unsigned long long last_samples; // At the previous report
+};
+
+struct acquire_out {
+    int fd;
+    char *buf;
+    size_t size;
+    size_t len;
+    unsigned long long bytes;  // Written to fd
+    int format;                // ACQUIRE_*
+    struct ads1115_ts_writer *ts; // ACQUIRE_TS, which does its own buffering
+};
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static int out_flush(struct acquire_out *out) {
+    size_t off = 0;
+    ssize_t n;
+
+    while (off < out->len) {
+        n = write(out->fd, out->buf + off, out->len - off);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -errno;
+        }
+        off += n;
+    }
+    out->bytes += out->len;
+    out->len = 0;
+    return 0;
+}
+
+// Room for need more bytes, flushing a full buffer first
+static int out_reserve(struct acquire_out *out, size_t need) {
+    if (out->len + need <= out->size)
+        return 0;
+    return out_flush(out);
+}
+
+static int emit(struct acquire_out *out, unsigned int index, const struct ads1115_sample *s, size_t n) {
+    struct acquire_record *rec;
+    size_t i;
+    int ret;
+
+    if (out->format == ACQUIRE_TS)
+        return ads1115_ts_append(out->ts, index, s, n);
+
+    for (i = 0; i < n; i++) {
+        if (out->format == ACQUIRE_CSV) {
+            ret = out_reserve(out, ACQUIRE_CSV_LINE);
+            if (ret < 0)
+                return ret;
+            out->len += snprintf(out->buf + out->len, ACQUIRE_CSV_LINE, "%llu,%u,%u,%d,%u,%u\n",
+                                 (unsigned long long)s[i].timestamp_ns, index, s[i].channel,
+                                 s[i].value, s[i].flags, s[i].seq);
+            continue;
+        }
+        ret = out_reserve(out, sizeof(*rec));
+        if (ret < 0)
+            return ret;
+        rec = (struct acquire_record *)(out->buf + out->len);
+        rec->timestamp_ns = s[i].timestamp_ns;
+        rec->value = s[i].value;
+        rec->device = index;
+        rec->channel = s[i].channel;
+        rec->flags = s[i].flags;
+        rec->reserved = 0;
+        rec->seq = s[i].seq;
+        out->len += sizeof(*rec);
+    }
+    return 0;
+}
+
+static int write_header(struct acquire_out *out, unsigned int num_devices,
+                        const struct ads1115_stream_config *cfg) {
+    struct acquire_header hdr = {
+        .version = 1,
+        .record_size = sizeof(struct acquire_record),
+        .num_devices = num_devices,
+        .channel_mask = cfg->channel_mask,
+        .data_rate = cfg->data_rate,
+    };
+
+    if (out->format == ACQUIRE_TS)
+        return 0;
+    if (out->format == ACQUIRE_CSV) {
+        out->len += snprintf(out->buf + out->len, out->size - out->len,
+                             "timestamp_ns,device,channel,value,flags,seq\n");
+        return 0;
+    }
+    memcpy(hdr.magic, ACQUIRE_MAGIC, sizeof(hdr.magic));
+    memcpy(out->buf + out->len, &hdr, sizeof(hdr));
+    out->len += sizeof(hdr);
+    return 0;
+}
+
+// Count sequence gaps, the driver numbers every sample it took, including
+// those it had to drop on a full ring
+static void account(struct acquire_dev *ad, const struct ads1115_sample *s, size_t n) {
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        if (ad->seen)
+            ad->drops += (uint16_t)(s[i].seq - ad->next_seq);
+        ad->seen = 1;
+        ad->next_seq = s[i].seq + 1;
+        if (s[i].flags & ADS1115_SAMPLE_GAP)
+            ad->gaps++;
+    }
+    ad->samples += n;
+}
+
+static void report(struct acquire_dev *devs, unsigned int num_devs, const struct acquire_out *out,
+                   double elapsed_s, double interval_s) {
+    unsigned int i;
+
+    fprintf(stderr, "%7.1fs", elapsed_s);
+    for (i = 0; i < num_devs; i++) {
+        fprintf(stderr, "  %s %.1f sps drops %llu", devs[i].name,
+                (devs[i].samples - devs[i].last_samples) / interval_s, devs[i].drops);
+        devs[i].last_samples = devs[i].samples;
+    }
+    if (out->format == ACQUIRE_TS)
+        fprintf(stderr, "\n");
+    else
+        fprintf(stderr, "  %.1f MB\n", (out->bytes + out->len) / 1e6);
+}
+
+// Real-time priority and CPU pinning so the reader is never the bottleneck
+static int set_realtime(int cpu, int fifo_prio) {
+    struct sched_param sp = { .sched_priority = fifo_prio };
+    cpu_set_t set;
+
+    if (cpu >= 0) {
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) < 0)
+            return -errno;
+    }
+    if (fifo_prio > 0) {
+        if (sched_setscheduler(0, SCHED_FIFO, &sp) < 0)
+            return -errno;
+        // A page fault in the write path would stall the loop for a whole pass
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0)
+            return -errno;
+    }
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-d chrdev]... [-i bus:addr]... [-m chips] [options]\n"
+            "  -d path       Driver device, repeat for more chips\n"
+            "  -i bus:addr   Chip on /dev/i2c-<bus> without the driver, repeatable\n"
+            "  -m chips      Software chips in real time, for trying the tool\n"
+            "  -c mask       Channel mask (default 0xf)\n"
+            "  -r code       DR code 0..7 (default 7, 860 samples/second)\n"
+            "  -f format     bin, csv or ts (default bin)\n"
+            "  -o file       Output file (default stdout, required for ts)\n"
+            "  -t seconds    Stop after this long (default until SIGINT/SIGTERM)\n"
+            "  -n samples    Stop after this many samples in total\n"
+            "  -B bytes      Write buffer size (default %d)\n"
+            "  -R slots      Driver ring size per device (default: driver's)\n"
+            "  -w samples    Driver watermark, samples per wakeup (default: driver's)\n"
+            "  -p cpu        Pin to this CPU\n"
+            "  -F prio       Run SCHED_FIFO at this priority and lock memory\n"
+            "  -q            No live report\n", prog, ACQUIRE_BUF_DEFAULT);
+}
+
+int main(int argc, char **argv) {
+    struct ads1115_stream_config cfg = { .channel_mask = 0xf, .data_rate = ADS1115_DR_MAX };
+    struct ads1115_buffer_config bufcfg = { 0 };
+    struct acquire_dev *devs;
+    struct acquire_out out = { .fd = STDOUT_FILENO, .size = ACQUIRE_BUF_DEFAULT };
+    struct ads1115_sample samples[ACQUIRE_CHUNK];
+    struct pollfd pfds[ACQUIRE_MAX_DEVICES];
+    unsigned int num_devs = 0, num_poll, i, k, models = 0, bus, addr;
+    unsigned long long limit = 0, total = 0;
+    const char *path = NULL;
+    double seconds = 0, elapsed, interval;
+    uint64_t t0, now, last_report;
+    int opt, cpu = -1, fifo_prio = 0, quiet = 0, ret = 0, flushed, any_soft = 0;
+    struct sigaction sa;
+    ssize_t n;
+
+    devs = calloc(ACQUIRE_MAX_DEVICES, sizeof(*devs));
+    if (!devs)
+        return EXIT_FAILURE;
+
+    while ((opt = getopt(argc, argv, "d:i:m:c:r:f:o:t:n:B:R:w:p:F:qh")) != -1) {
+        switch (opt) {
+        case 'd':
+        case 'i':
+            if (num_devs == ACQUIRE_MAX_DEVICES) {
+                fprintf(stderr, "At most %d devices\n", ACQUIRE_MAX_DEVICES);
+                return EXIT_FAILURE;
+            }
+            if (opt == 'd') {
+                devs[num_devs].dev = ads1115_open_chrdev(optarg);
+            } else if (sscanf(optarg, "%u:%i", &bus, &addr) == 2) {
+                devs[num_devs].dev = ads1115_open_i2cdev(bus, addr);
+            } else {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (!devs[num_devs].dev) {
+                fprintf(stderr, "Failed to open %s: %s\n", optarg, strerror(errno));
+                return EXIT_FAILURE;
+            }
+            devs[num_devs++].name = optarg;
+            break;
+        case 'm': models = strtoul(optarg, NULL, 0); break;
+        case 'c': cfg.channel_mask = strtoul(optarg, NULL, 0); break;
+        case 'r': cfg.data_rate = strtoul(optarg, NULL, 0); break;
+        case 'f':
+            for (out.format = 0; out.format <= ACQUIRE_TS; out.format++)
+                if (!strcmp(optarg, format_names[out.format]))
+                    break;
+            if (out.format > ACQUIRE_TS) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'o': path = optarg; break;
+        case 't': seconds = strtod(optarg, NULL); break;
+        case 'n': limit = strtoull(optarg, NULL, 0); break;
+        case 'B': out.size = strtoul(optarg, NULL, 0); break;
+        case 'R': bufcfg.ring_size = strtoul(optarg, NULL, 0); break;
+        case 'w': bufcfg.watermark = strtoul(optarg, NULL, 0); break;
+        case 'p': cpu = strtol(optarg, NULL, 0); break;
+        case 'F': fifo_prio = strtol(optarg, NULL, 0); break;
+        case 'q': quiet = 1; break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (num_devs + models > ACQUIRE_MAX_DEVICES || !(num_devs + models) ||
+        out.size < sizeof(struct acquire_header) + ACQUIRE_CSV_LINE) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < models; i++, num_devs++) {
+        ads1115_model_init(&devs[num_devs].model, num_devs + 1);
+        for (k = 0; k < ADS1115_NUM_CHANNELS; k++) {
+            devs[num_devs].model.signals[k].offset_uv = (k + 1) * 500000;
+            devs[num_devs].model.signals[k].noise_uv = 200;
+        }
+        devs[num_devs].dev = ads1115_open_model(&devs[num_devs].model, NULL);
+        devs[num_devs].name = "model";
+        if (!devs[num_devs].dev) {
+            perror("Failed to open a software chip");
+            return EXIT_FAILURE;
+        }
+    }
+
+    out.buf = malloc(out.size);
+    if (!out.buf) {
+        perror("Failed to allocate the write buffer");
+        return EXIT_FAILURE;
+    }
+    if (out.format == ACQUIRE_TS) {
+        struct ads1115_ts_header info = { .num_devices = num_devs };
+
+        if (!path || !strcmp(path, "-")) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        for (i = 0; i < num_devs; i++) {
+            info.devices[i].channel_mask = cfg.channel_mask;
+            info.devices[i].data_rate = cfg.data_rate;
+            memset(info.devices[i].pga, ADS1115_TS_PGA_UNKNOWN, sizeof(info.devices[i].pga));
+        }
+        out.ts = ads1115_ts_create(path, &info);
+        if (!out.ts) {
+            fprintf(stderr, "Failed to create %s: %s\n", path, strerror(errno));
+            return EXIT_FAILURE;
+        }
+    } else if (path && strcmp(path, "-")) {
+        out.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out.fd < 0) {
+            fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    ret = set_realtime(cpu, fifo_prio);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to set CPU %d / SCHED_FIFO %d: %s\n", cpu, fifo_prio, strerror(-ret));
+        return EXIT_FAILURE;
+    }
+
+    // No SA_RESTART: a signal must break poll() and blocking reads
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    num_poll = 0;
+    t0 = ads1115_now_ns();
+    for (i = 0; i < num_devs; i++) {
+        devs[i].poll_fd = ads1115_poll_fd(devs[i].dev);
+        if (devs[i].poll_fd >= 0 && (bufcfg.ring_size || bufcfg.watermark)) {
+            ret = ads1115_set_buffer(devs[i].dev, &bufcfg);
+            if (ret < 0) {
+                fprintf(stderr, "%s: failed to set the ring: %s\n", devs[i].name, strerror(-ret));
+                goto out;
+            }
+        }
+        ret = ads1115_stream_start(devs[i].dev, &cfg);
+        if (ret < 0) {
+            fprintf(stderr, "%s: failed to start streaming: %s\n", devs[i].name, strerror(-ret));
+            goto out;
+        }
+        devs[i].started = 1;
+        if (devs[i].poll_fd >= 0) {
+            pfds[num_poll].fd = devs[i].poll_fd;
+            pfds[num_poll++].events = POLLIN;
+        } else {
+            any_soft = 1;
+        }
+    }
+    write_header(&out, num_devs, &cfg);
+
+    t0 = last_report = ads1115_now_ns();
+    while (!stop) {
+        // Userspace backends convert in read(), so never sleep in poll() for them
+        if (num_poll && poll(pfds, num_poll, any_soft ? 0 : 200) < 0 && errno != EINTR) {
+            ret = -errno;
+            perror("poll");
+            break;
+        }
+
+        for (i = 0, k = 0; i < num_devs && !stop; i++) {
+            if (devs[i].poll_fd >= 0 && !(pfds[k++].revents & (POLLIN | POLLERR | POLLHUP)))
+                continue;
+            n = ads1115_stream_read(devs[i].dev, samples, ACQUIRE_CHUNK);
+            if (n == -EINTR || n == -EAGAIN)
+                continue;
+            if (!n && devs[i].poll_fd >= 0) {
+                fprintf(stderr, "%s: stream stopped\n", devs[i].name);
+                stop = 1;
+                break;
+            }
+            if (n < 0) {
+                fprintf(stderr, "%s: read failed: %s\n", devs[i].name, strerror(-n));
+                ret = n;
+                stop = 1;
+                break;
+            }
+            account(&devs[i], samples, n);
+            ret = emit(&out, i, samples, n);
+            if (ret < 0) {
+                fprintf(stderr, "Write failed: %s\n", strerror(-ret));
+                stop = 1;
+                break;
+            }
+            total += n;
+        }
+
+        now = ads1115_now_ns();
+        elapsed = (now - t0) / 1e9;
+        interval = (now - last_report) / 1e9;
+        if (!quiet && interval >= 1.0) {
+            report(devs, num_devs, &out, elapsed, interval);
+            last_report = now;
+        }
+        if ((limit && total >= limit) || (seconds > 0 && elapsed >= seconds))
+            break;
+    }
+
+out:
+    for (i = 0; i < num_devs; i++)
+        if (devs[i].started)
+            ads1115_stream_stop(devs[i].dev);
+    flushed = out_flush(&out);
+    if (flushed < 0) {
+        fprintf(stderr, "Write failed: %s\n", strerror(-flushed));
+        ret = flushed;
+    }
+    if (out.ts && (flushed = ads1115_ts_close(out.ts)) < 0) {
+        fprintf(stderr, "Failed to finish %s: %s\n", path, strerror(-flushed));
+        ret = flushed;
+    }
+
+    elapsed = (ads1115_now_ns() - t0) / 1e9;
+    for (i = 0; i < num_devs; i++) {
+        fprintf(stderr, "%s: %llu samples, %.1f sps, %llu dropped, %llu after bus recovery\n",
+                devs[i].name, devs[i].samples, elapsed > 0 ? devs[i].samples / elapsed : 0,
+                devs[i].drops, devs[i].gaps);
+        ads1115_close(devs[i].dev);
+    }
+    if (out.fd != STDOUT_FILENO)
+        close(out.fd);
+    free(out.buf);
+    free(devs);
+    return ret < 0 ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/resource.h>
+
+#include "ads1115_bench.h"
+
+#define BENCH_READ_BATCH 64 // Samples requested per stream read
+
+static const char *const bench_mode_names[ADS1115_BENCH_NUM_MODES] = {
+    [ADS1115_BENCH_SINGLE] = "single",
+    [ADS1115_BENCH_SCAN]   = "scan",
+    [ADS1115_BENCH_BURST]  = "burst",
+    [ADS1115_BENCH_STREAM] = "stream",
+};
+
+const char *ads1115_bench_mode_name(enum ads1115_bench_mode mode) {
+    return mode < ADS1115_BENCH_NUM_MODES ? bench_mode_names[mode] : "unknown";
+}
+
+int ads1115_bench_mode_parse(const char *name) {
+    int i;
+
+    for (i = 0; i < ADS1115_BENCH_NUM_MODES; i++)
+        if (!strcmp(name, bench_mode_names[i]))
+            return i;
+    return -EINVAL;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+void ads1115_lat_summarize(uint64_t *lat_ns, size_t n, struct ads1115_lat_summary *out) {
+    uint64_t sum = 0;
+    size_t i;
+
+    memset(out, 0, sizeof(*out));
+    if (!n)
+        return;
+
+    qsort(lat_ns, n, sizeof(*lat_ns), cmp_u64);
+    for (i = 0; i < n; i++)
+        sum += lat_ns[i];
+
+    out->count = n;
+    out->mean_us = sum / 1e3 / n;
+    out->p50_us = lat_ns[n / 2] / 1e3;
+    out->p99_us = lat_ns[n * 99 / 100] / 1e3;
+    out->p999_us = lat_ns[n * 999 / 1000] / 1e3;
+    out->max_us = lat_ns[n - 1] / 1e3;
+}
+
+static double tv_us(struct timeval tv) {
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+// Delivery latency of streamed samples: read return time minus sample timestamp
+static int bench_stream(struct ads1115_dev *dev, uint32_t mask, uint32_t data_rate,
+                        size_t count, uint64_t *lat, size_t *n) {
+    struct ads1115_stream_config cfg = { .channel_mask = mask, .data_rate = data_rate };
+    struct ads1115_sample buf[BENCH_READ_BATCH];
+    size_t want, end = *n + count;
+    uint64_t t;
+    ssize_t k, i;
+    int ret;
+
+    ret = ads1115_stream_start(dev, &cfg);
+    if (ret < 0)
+        return ret;
+
+    while (*n < end) {
+        want = end - *n < BENCH_READ_BATCH ? end - *n : BENCH_READ_BATCH;
+        k = ads1115_stream_read(dev, buf, want);
+        if (k <= 0) {
+            ret = k ? (int)k : -EIO; // Stream ended early
+            break;
+        }
+        t = ads1115_dev_now_ns(dev);
+        for (i = 0; i < k; i++)
+            lat[(*n)++] = t - buf[i].timestamp_ns;
+    }
+
+    ads1115_stream_stop(dev);
+    return ret;
+}
+
+int ads1115_bench_run(struct ads1115_dev *dev, const struct ads1115_bench_params *p,
+                      struct ads1115_bench_result *r) {
+    unsigned int first = __builtin_ctz(p->channel_mask);
+    int16_t values[ADS1115_NUM_CHANNELS];
+    struct ads1115_dev_stats st0, st1;
+    struct rusage ru0, ru1;
+    uint64_t *lat, t0, t;
+    size_t n = 0, burst, i;
+    int ret = 0;
+
+    if (!p->channel_mask || !p->samples)
+        return -EINVAL;
+
+    lat = calloc(p->samples + ADS1115_NUM_CHANNELS, sizeof(*lat));
+    if (!lat)
+        return -ENOMEM;
+
+    ads1115_get_stats(dev, &st0);
+    getrusage(RUSAGE_SELF, &ru0);
+    t0 = ads1115_dev_now_ns(dev);
+
+    switch (p->mode) {
+    case ADS1115_BENCH_SINGLE:
+        while (n < p->samples && ret >= 0) {
+            t = ads1115_dev_now_ns(dev);
+            ret = ads1115_read_channel(dev, first, &values[0]);
+            lat[n++] = ads1115_dev_now_ns(dev) - t;
+        }
+        break;
+    case ADS1115_BENCH_SCAN:
+        // Every sample of a scan shares the latency of the call
+        while (n < p->samples && ret >= 0) {
+            t = ads1115_dev_now_ns(dev);
+            ret = ads1115_scan(dev, p->channel_mask, values);
+            t = ads1115_dev_now_ns(dev) - t;
+            for (i = 0; i < ADS1115_NUM_CHANNELS; i++)
+                if (p->channel_mask & (1u << i))
+                    lat[n++] = t;
+        }
+        break;
+    case ADS1115_BENCH_BURST:
+        while (n < p->samples && ret >= 0) {
+            burst = p->burst_len ? p->burst_len : 32;
+            if (burst > p->samples - n)
+                burst = p->samples - n;
+            ret = bench_stream(dev, 1u << first, p->data_rate, burst, lat, &n);
+        }
+        break;
+    case ADS1115_BENCH_STREAM:
+        ret = bench_stream(dev, p->channel_mask, p->data_rate, p->samples, lat, &n);
+        break;
+    default:
+        ret = -EINVAL;
+        break;
+    }
+
+    t = ads1115_dev_now_ns(dev) - t0;
+    getrusage(RUSAGE_SELF, &ru1);
+    ads1115_get_stats(dev, &st1);
+
+    if (ret < 0) {
+        free(lat);
+        return ret;
+    }
+
+    memset(r, 0, sizeof(*r));
+    r->samples = n;
+    r->elapsed_s = t / 1e9;
+    r->rate_sps = r->elapsed_s > 0 ? n / r->elapsed_s : 0;
+    r->cpu_us_per_sample = (tv_us(ru1.ru_utime) - tv_us(ru0.ru_utime) +
+                            tv_us(ru1.ru_stime) - tv_us(ru0.ru_stime)) / n;
+    r->wakeups_per_s = r->elapsed_s > 0 ?
+                       ((ru1.ru_nvcsw - ru0.ru_nvcsw) + (ru1.ru_nivcsw - ru0.ru_nivcsw)) / r->elapsed_s : 0;
+    r->syscalls_per_sample = (double)(st1.syscalls - st0.syscalls) / n;
+    r->transactions_per_sample = (double)(st1.transactions - st0.transactions) / n;
+    ads1115_lat_summarize(lat, n, &r->lat);
+    free(lat);
+    return 0;
+}
+
+void ads1115_bench_print_json(FILE *out, struct ads1115_dev *dev, const struct ads1115_bench_params *p,
+                              const struct ads1115_bench_result *r) {
+    fprintf(out,
+            "{\"backend\":\"%s\",\"mode\":\"%s\",\"channel_mask\":%u,\"data_rate\":%u,"
+            "\"samples\":%zu,\"elapsed_s\":%.6f,\"rate_sps\":%.2f,"
+            "\"lat_mean_us\":%.1f,\"lat_p50_us\":%.1f,\"lat_p99_us\":%.1f,\"lat_p999_us\":%.1f,"
+            "\"lat_max_us\":%.1f,\"cpu_us_per_sample\":%.3f,\"wakeups_per_s\":%.1f,"
+            "\"syscalls_per_sample\":%.3f,\"transactions_per_sample\":%.3f}\n",
+            ads1115_backend_name(dev), ads1115_bench_mode_name(p->mode), p->channel_mask,
+            p->data_rate, r->samples, r->elapsed_s, r->rate_sps,
+            r->lat.mean_us, r->lat.p50_us, r->lat.p99_us, r->lat.p999_us, r->lat.max_us,
+            r->cpu_us_per_sample, r->wakeups_per_s, r->syscalls_per_sample,
+            r->transactions_per_sample);
+}
@@ -0,0 +1,63 @@
+#ifndef ADS1115_BENCH_H
+#define ADS1115_BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ads1115_lib.h"
+
+// Benchmark runners shared by the benchmark tools. Each access mode is
+// timed per sample through the public client API, so the same numbers come
+// out of the kernel driver, the i2c-dev backend and the software model.
+
+enum ads1115_bench_mode {
+    ADS1115_BENCH_SINGLE, // One ioctl/conversion per sample
+    ADS1115_BENCH_SCAN,   // All selected channels per call
+    ADS1115_BENCH_BURST,  // Start a one-channel stream, take N samples, stop
+    ADS1115_BENCH_STREAM, // Sustained streaming read of the selected channels
+    ADS1115_BENCH_NUM_MODES,
+};
+
+struct ads1115_bench_params {
+    enum ads1115_bench_mode mode;
+    uint32_t channel_mask; // Channels to convert, lowest one for single/burst
+    uint32_t data_rate;    // DR code for stream and burst
+    size_t samples;        // Samples to time
+    size_t burst_len;      // Samples per burst
+};
+
+struct ads1115_lat_summary {
+    size_t count;
+    double mean_us;
+    double p50_us;
+    double p99_us;
+    double p999_us;
+    double max_us;
+};
+
+struct ads1115_bench_result {
+    size_t samples;            // Samples actually received
+    double elapsed_s;          // Wall time for the run
+    double rate_sps;           // Achieved samples per second
+    double cpu_us_per_sample;  // User + system time of this process
+    double wakeups_per_s;      // Context switches of this process
+    double syscalls_per_sample;
+    double transactions_per_sample; // Userspace backends only, 0 for chrdev
+    struct ads1115_lat_summary lat;
+};
+
+const char *ads1115_bench_mode_name(enum ads1115_bench_mode mode);
+int ads1115_bench_mode_parse(const char *name);
+
+// Sorts lat_ns in place
+void ads1115_lat_summarize(uint64_t *lat_ns, size_t n, struct ads1115_lat_summary *out);
+
+int ads1115_bench_run(struct ads1115_dev *dev, const struct ads1115_bench_params *p,
+                      struct ads1115_bench_result *r);
+
+// One JSON object per line
+void ads1115_bench_print_json(FILE *out, struct ads1115_dev *dev, const struct ads1115_bench_params *p,
+                              const struct ads1115_bench_result *r);
+
+#endif
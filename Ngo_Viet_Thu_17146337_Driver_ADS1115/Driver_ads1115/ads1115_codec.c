@@ -0,0 +1,367 @@
+#include <string.h>
+#include <errno.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#define CODEC_HAVE_SIMD 1
+#else
+#define CODEC_HAVE_SIMD 0
+#endif
+
+#include "ads1115_codec.h"
+
+#define CODEC_PAD 8 // Zero bytes after the last frame, unpacking reads whole words
+
+// Start of an encoded block, the columns follow
+struct codec_header {
+    uint64_t first_delta_ns; // timestamp_ns[1] - timestamp_ns[0]
+    int16_t first_value;
+    uint16_t first_seq;
+    uint16_t seq_delta;      // seq[1] - seq[0]
+    uint8_t first_flags;
+    uint8_t reserved;
+};
+
+_Static_assert(sizeof(struct codec_header) == 16, "codec_header layout");
+
+struct bit_writer {
+    uint8_t *p;
+    uint64_t acc;
+    unsigned int n; // Bits held in acc, always < 64
+};
+
+static int codec_simd = CODEC_HAVE_SIMD;
+
+static inline uint64_t load_le64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v)); // Files are in host byte order
+    return v;
+}
+
+static inline uint64_t zigzag64(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag64(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static inline uint16_t zigzag16(int16_t v) {
+    return (uint16_t)(((uint16_t)v << 1) ^ (uint16_t)(v >> 15));
+}
+
+static inline unsigned int bit_width(uint64_t v) {
+    return v ? 64 - __builtin_clzll(v) : 0;
+}
+
+static void bw_put(struct bit_writer *bw, uint64_t v, unsigned int w) {
+    unsigned int used;
+
+    if (!w)
+        return;
+    bw->acc |= v << bw->n;
+    if (bw->n + w < 64) {
+        bw->n += w;
+        return;
+    }
+    memcpy(bw->p, &bw->acc, sizeof(bw->acc));
+    bw->p += sizeof(bw->acc);
+    used = 64 - bw->n; // Bits of v already in the word
+    bw->acc = used < 64 ? v >> used : 0;
+    bw->n = bw->n + w - 64;
+}
+
+static void bw_flush(struct bit_writer *bw) {
+    unsigned int bytes = (bw->n + 7) / 8;
+
+    memcpy(bw->p, &bw->acc, bytes);
+    bw->p += bytes;
+    bw->acc = 0;
+    bw->n = 0;
+}
+
+// Residual i of one column, zigzag coded
+typedef uint64_t (*residual_fn)(const void *col, uint32_t i);
+
+static uint64_t ts_residual(const void *col, uint32_t i) {
+    const uint64_t *ts = col;
+
+    if (i < 2)
+        return 0;
+    return zigzag64((int64_t)((ts[i] - ts[i - 1]) - (ts[i - 1] - ts[i - 2])));
+}
+
+static uint64_t value_residual(const void *col, uint32_t i) {
+    const int16_t *v = col;
+
+    return i ? zigzag16((int16_t)(v[i] - v[i - 1])) : 0;
+}
+
+static uint64_t seq_residual(const void *col, uint32_t i) {
+    const uint16_t *s = col;
+
+    if (i < 2)
+        return 0;
+    return zigzag16((int16_t)((uint16_t)(s[i] - s[i - 1]) - (uint16_t)(s[i - 1] - s[i - 2])));
+}
+
+static uint64_t flags_residual(const void *col, uint32_t i) {
+    const uint8_t *f = col;
+
+    return i ? f[i] ^ f[i - 1] : 0;
+}
+
+// Frames of one column: width byte, then the residuals packed LSB first
+static uint8_t *pack_column(uint8_t *out, const void *col, uint32_t count, residual_fn residual) {
+    struct bit_writer bw = { 0 };
+    uint32_t start, i, n;
+    uint64_t any;
+    unsigned int w;
+
+    for (start = 0; start < count; start += n) {
+        n = count - start < ADS1115_CODEC_FRAME ? count - start : ADS1115_CODEC_FRAME;
+        for (any = 0, i = 0; i < n; i++)
+            any |= residual(col, start + i);
+        w = bit_width(any);
+        *out++ = w;
+        bw.p = out;
+        for (i = 0; i < n; i++)
+            bw_put(&bw, residual(col, start + i), w);
+        bw_flush(&bw);
+        out = bw.p;
+    }
+    return out;
+}
+
+size_t ads1115_codec_bound(uint32_t count) {
+    size_t frames = (count + ADS1115_CODEC_FRAME - 1) / ADS1115_CODEC_FRAME;
+
+    return sizeof(struct codec_header) + (size_t)count * (8 + 2 + 2 + 1) + frames * 4 + CODEC_PAD;
+}
+
+size_t ads1115_codec_encode(const uint64_t *timestamp_ns, const int16_t *value, const uint16_t *seq,
+                            const uint8_t *flags, uint32_t count, uint8_t *out) {
+    struct codec_header hdr = {
+        .first_value = value[0],
+        .first_seq = seq[0],
+        .first_flags = flags[0],
+    };
+    uint8_t *p = out + sizeof(hdr);
+
+    if (count > 1) {
+        hdr.first_delta_ns = timestamp_ns[1] - timestamp_ns[0];
+        hdr.seq_delta = seq[1] - seq[0];
+    }
+    memcpy(out, &hdr, sizeof(hdr));
+
+    p = pack_column(p, timestamp_ns, count, ts_residual);
+    p = pack_column(p, value, count, value_residual);
+    p = pack_column(p, seq, count, seq_residual);
+    p = pack_column(p, flags, count, flags_residual);
+    memset(p, 0, CODEC_PAD);
+    return p + CODEC_PAD - out;
+}
+
+static inline uint64_t get_bits(const uint8_t *base, size_t pos, unsigned int w) {
+    const uint8_t *p = base + (pos >> 3);
+    unsigned int sh = pos & 7;
+    uint64_t v = load_le64(p) >> sh;
+
+    if (sh + w > 64)
+        v |= (uint64_t)p[8] << (64 - sh);
+    return w == 64 ? v : v & ((1ull << w) - 1);
+}
+
+// Next frame of a column: its residual count, bit width and packed data.
+// end already excludes the trailing pad.
+static int next_frame(const uint8_t **pp, const uint8_t *end, uint32_t left, unsigned int max_w,
+                      uint32_t *n, unsigned int *w, const uint8_t **data) {
+    const uint8_t *p = *pp;
+    size_t bytes;
+
+    *n = left < ADS1115_CODEC_FRAME ? left : ADS1115_CODEC_FRAME;
+    if (p >= end || (*w = *p++) > max_w)
+        return -EBADMSG;
+    bytes = ((size_t)*n * *w + 7) / 8;
+    if ((size_t)(end - p) < bytes)
+        return -EBADMSG;
+    *data = p;
+    *pp = p + bytes;
+    return 0;
+}
+
+static int unpack64(const uint8_t **pp, const uint8_t *end, uint32_t count, uint64_t *out) {
+    const uint8_t *data;
+    uint32_t start, n, i;
+    unsigned int w;
+
+    for (start = 0; start < count; start += n) {
+        if (next_frame(pp, end, count - start, 64, &n, &w, &data) < 0)
+            return -EBADMSG;
+        for (i = 0; i < n; i++)
+            out[start + i] = w ? get_bits(data, (size_t)i * w, w) : 0;
+    }
+    return 0;
+}
+
+static int unpack16(const uint8_t **pp, const uint8_t *end, uint32_t count, uint16_t *out) {
+    const uint8_t *data;
+    uint32_t start, n, i;
+    unsigned int w;
+
+    for (start = 0; start < count; start += n) {
+        if (next_frame(pp, end, count - start, 16, &n, &w, &data) < 0)
+            return -EBADMSG;
+        if (!w) {
+            memset(out + start, 0, n * sizeof(*out));
+            continue;
+        }
+        for (i = 0; i < n; i++)
+            out[start + i] = get_bits(data, (size_t)i * w, w);
+    }
+    return 0;
+}
+
+static int unpack8(const uint8_t **pp, const uint8_t *end, uint32_t count, uint8_t *out) {
+    const uint8_t *data;
+    uint32_t start, n, i;
+    unsigned int w;
+
+    for (start = 0; start < count; start += n) {
+        if (next_frame(pp, end, count - start, 8, &n, &w, &data) < 0)
+            return -EBADMSG;
+        if (!w) {
+            memset(out + start, 0, n);
+            continue;
+        }
+        for (i = 0; i < n; i++)
+            out[start + i] = get_bits(data, (size_t)i * w, w);
+    }
+    return 0;
+}
+
+static void unzigzag16_scalar(uint16_t *x, uint32_t n) {
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+        x[i] = (x[i] >> 1) ^ -(x[i] & 1);
+}
+
+// Inclusive running sum modulo 2^16
+static void prefix16_scalar(uint16_t *x, uint32_t n) {
+    uint32_t i;
+
+    for (i = 1; i < n; i++)
+        x[i] += x[i - 1];
+}
+
+#if CODEC_HAVE_SIMD
+static void unzigzag16_sse2(uint16_t *x, uint32_t n) {
+    const __m128i one = _mm_set1_epi16(1);
+    uint32_t i;
+    __m128i v;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        v = _mm_loadu_si128((const __m128i *)(x + i));
+        v = _mm_xor_si128(_mm_srli_epi16(v, 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(v, one)));
+        _mm_storeu_si128((__m128i *)(x + i), v);
+    }
+    unzigzag16_scalar(x + i, n - i);
+}
+
+// Log-step scan inside each vector, then the last lane carried into the next
+static void prefix16_sse2(uint16_t *x, uint32_t n) {
+    __m128i carry = _mm_setzero_si128(), v;
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        v = _mm_loadu_si128((const __m128i *)(x + i));
+        v = _mm_add_epi16(v, _mm_slli_si128(v, 2));
+        v = _mm_add_epi16(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi16(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi16(v, carry);
+        _mm_storeu_si128((__m128i *)(x + i), v);
+        carry = _mm_shufflehi_epi16(v, 0xff);
+        carry = _mm_unpackhi_epi64(carry, carry);
+    }
+    for (; i < n; i++)
+        x[i] += i ? x[i - 1] : 0;
+}
+#endif
+
+static void unzigzag16(uint16_t *x, uint32_t n) {
+#if CODEC_HAVE_SIMD
+    if (codec_simd) {
+        unzigzag16_sse2(x, n);
+        return;
+    }
+#endif
+    unzigzag16_scalar(x, n);
+}
+
+static void prefix16(uint16_t *x, uint32_t n) {
+#if CODEC_HAVE_SIMD
+    if (codec_simd) {
+        prefix16_sse2(x, n);
+        return;
+    }
+#endif
+    prefix16_scalar(x, n);
+}
+
+int ads1115_codec_decode(const uint8_t *in, size_t len, uint32_t count, uint64_t first_ns,
+                         uint64_t *timestamp_ns, int16_t *value, uint16_t *seq, uint8_t *flags) {
+    const uint8_t *p = in + sizeof(struct codec_header), *end;
+    struct codec_header hdr;
+    uint64_t delta;
+    uint32_t i;
+    int ret;
+
+    if (!count || len < sizeof(hdr) + CODEC_PAD)
+        return -EBADMSG;
+    memcpy(&hdr, in, sizeof(hdr));
+    end = in + len - CODEC_PAD;
+
+    ret = unpack64(&p, end, count, timestamp_ns);
+    if (!ret)
+        ret = unpack16(&p, end, count, (uint16_t *)value);
+    if (!ret)
+        ret = unpack16(&p, end, count, seq);
+    if (!ret)
+        ret = unpack8(&p, end, count, flags);
+    if (ret < 0)
+        return ret;
+
+    // Timestamps: undo delta-of-delta
+    delta = hdr.first_delta_ns;
+    timestamp_ns[0] = first_ns;
+    for (i = 1; i < count; i++) {
+        if (i > 1)
+            delta += unzigzag64(timestamp_ns[i]);
+        timestamp_ns[i] = timestamp_ns[i - 1] + delta;
+    }
+
+    // Values: one running sum of the deltas
+    unzigzag16((uint16_t *)value, count);
+    value[0] = hdr.first_value;
+    prefix16((uint16_t *)value, count);
+
+    // Sequence numbers: two running sums
+    unzigzag16(seq, count);
+    if (count > 1)
+        seq[1] = hdr.seq_delta;
+    seq[0] = 0;
+    prefix16(seq, count);
+    seq[0] = hdr.first_seq;
+    prefix16(seq, count);
+
+    flags[0] = hdr.first_flags;
+    for (i = 1; i < count; i++)
+        flags[i] ^= flags[i - 1];
+    return 0;
+}
+
+int ads1115_codec_use_simd(int enable) {
+    codec_simd = enable && CODEC_HAVE_SIMD;
+    return codec_simd;
+}
@@ -0,0 +1,38 @@
+#ifndef ADS1115_CODEC_H
+#define ADS1115_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Compression of one block of a recorded channel (see ads1115_tsfile.h).
+// Each column becomes a stream of small residuals:
+//   timestamps  delta-of-delta, first delta kept in the header
+//   values      delta from the previous sample
+//   seq         delta-of-delta, constant steps cost nothing
+//   flags       XOR with the previous sample
+// Residuals are zigzag coded and bit-packed in frames of
+// ADS1115_CODEC_FRAME, each frame with its own bit width, so a quiet frame
+// of an otherwise noisy block stays small. Blocks decode independently.
+// Decoding reconstructs values and seq 8 lanes at a time with SSE2 where the
+// compiler targets it.
+
+#define ADS1115_CODEC_FRAME 128 // Residuals per bit width
+
+// Upper bound of the encoded size of count samples
+size_t ads1115_codec_bound(uint32_t count);
+
+// Encode count >= 1 samples into out (ads1115_codec_bound(count) bytes).
+// Returns the encoded size.
+size_t ads1115_codec_encode(const uint64_t *timestamp_ns, const int16_t *value, const uint16_t *seq,
+                            const uint8_t *flags, uint32_t count, uint8_t *out);
+
+// Decode count samples from len bytes. first_ns is the block's first
+// timestamp. Returns 0, or -EBADMSG if in is malformed.
+int ads1115_codec_decode(const uint8_t *in, size_t len, uint32_t count, uint64_t first_ns,
+                         uint64_t *timestamp_ns, int16_t *value, uint16_t *seq, uint8_t *flags);
+
+// Choose the SIMD or the scalar decoder, for benchmarks. Returns 1 if the
+// SIMD decoder is now in use, 0 if it is not available.
+int ads1115_codec_use_simd(int enable);
+
+#endif
@@ -3,8 +3,33 @@
 #include <linux/i2c.h>
 #include <linux/device.h>
 #include <linux/fs.h>
+#include <linux/cdev.h>
+#include <linux/idr.h>
 #include <linux/uaccess.h>
 #include <linux/delay.h>
+#include <linux/slab.h>
+#include <linux/kthread.h>
+#include <linux/mutex.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/uio.h>
+#include <linux/ktime.h>
+#include <linux/percpu.h>
+#include <linux/log2.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/workqueue.h>
+#include <linux/property.h>
+#include <linux/interrupt.h>
+#include <linux/completion.h>
+#include <linux/mm.h>
+#include <linux/kref.h>
+#include <linux/regulator/consumer.h>
+
+#include "ads1115_uapi.h"
+
+#define CREATE_TRACE_POINTS
+#include "ads1115_trace.h"
 
 #define DRIVER_NAME "ads1115_driver" // Driver name for logging and I2C
 #define CLASS_NAME  "ads1115"         // Class name in sysfs
@@ -13,6 +38,8 @@
 // ADS1115 register addresses
 #define ADS1115_REG_POINTER_CONVERSION  0x00 // ADC result register
 #define ADS1115_REG_POINTER_CONFIG      0x01 // Configuration register
+#define ADS1115_REG_POINTER_LO_THRESH   0x02 // Comparator low threshold
+#define ADS1115_REG_POINTER_HI_THRESH   0x03 // Comparator high threshold
 
 // Config register bits
 #define ADS1115_CONFIG_OS_SINGLE        0x8000 // Start single conversion
@@ -20,125 +47,1420 @@
 #define ADS1115_CONFIG_PGA_OFFSET       9      // PGA bit offset
 #define ADS1115_CONFIG_MODE_SINGLE      0x0100 // Single-shot mode
 #define ADS1115_CONFIG_DR_OFFSET        5      // Data rate bit offset
+#define ADS1115_CONFIG_COMP_QUE_OFF     0x0003 // Comparator and ALERT/RDY pin disabled
 
 // MUX config for analog channels
 #define ADS1115_MUX_AIN0_GND (0x04 << ADS1115_CONFIG_MUX_OFFSET) // Channel AIN0 vs GND
 #define ADS1115_MUX_AIN1_GND (0x05 << ADS1115_CONFIG_MUX_OFFSET) // Channel AIN1 vs GND
 #define ADS1115_MUX_AIN2_GND (0x06 << ADS1115_CONFIG_MUX_OFFSET) // Channel AIN2 vs GND
 #define ADS1115_MUX_AIN3_GND (0x07 << ADS1115_CONFIG_MUX_OFFSET) // Channel AIN3 vs GND
+#define ADS1115_MUX_AIN_GND(ch) ((0x04 + (ch)) << ADS1115_CONFIG_MUX_OFFSET) // Channel AINx vs GND
+
+#define ADS1115_MUX_MAX    0x07 // Highest MUX code
 
 // PGA and data rate config
-#define ADS1115_PGA_4_096V (0x01 << ADS1115_CONFIG_PGA_OFFSET) // Gain +/-4.096V
-#define ADS1115_DR_128SPS  (0x04 << ADS1115_CONFIG_DR_OFFSET)  // 128 samples/second
-
-// Base config for Config register
-#define ADS1115_CONFIG_BASE (ADS1115_CONFIG_OS_SINGLE | \
-                             ADS1115_PGA_4_096V | \
-                             ADS1115_CONFIG_MODE_SINGLE | \
-                             ADS1115_DR_128SPS | \
-                             0x0003) // Disable comparator
-
-// IOCTL commands
-#define ADS1115_IOCTL_MAGIC 'a' // IOCTL magic character
-#define ADS1115_IOCTL_READ_AIN0 _IOR(ADS1115_IOCTL_MAGIC, 0, s16) // Read AIN0
-#define ADS1115_IOCTL_READ_AIN1 _IOR(ADS1115_IOCTL_MAGIC, 1, s16) // Read AIN1
-#define ADS1115_IOCTL_READ_AIN2 _IOR(ADS1115_IOCTL_MAGIC, 2, s16) // Read AIN2
-#define ADS1115_IOCTL_READ_AIN3 _IOR(ADS1115_IOCTL_MAGIC, 3, s16) // Read AIN3
+#define ADS1115_PGA_4_096V 0x01 // Gain +/-4.096V (PGA code)
+#define ADS1115_PGA_MAX    0x05 // Gain +/-0.256V, codes 6 and 7 are the same
+#define ADS1115_XFER_INIT_US 250 // Bus transfer estimate before one is measured (100 kHz word)
+#define ADS1115_CODE_UNKNOWN 0xff // No previous conversion to compare MUX/PGA with
+#define ADS1115_DR_128SPS  0x04 // 128 samples/second (DR code)
+#define ADS1115_DR_MAX     0x07 // Highest DR code (860 or 3300 samples/second)
+
+// Base config for Config register, MUX, PGA, data rate and comparator are added per conversion
+#define ADS1115_CONFIG_BASE (ADS1115_CONFIG_OS_SINGLE | ADS1115_CONFIG_MODE_SINGLE)
+
+// Conversion completion
+#define ADS1115_POLL_INTERVAL_US 50 // Gap between OS bit polls
+
+// Streaming
+#define ADS1115_MAX_DEVICES     4    // One chip per address pin strapping
+#define ADS1115_NUM_CHANNELS    4    // Single-ended inputs AIN0..AIN3
+#define ADS1115_RING_SIZE       1024 // Default samples held in the stream ring (power of two)
+#define ADS1115_RING_MIN        16   // Smallest ring_size
+#define ADS1115_RING_MAX        65536 // Largest ring_size, 1 MiB of samples
+#define ADS1115_ERR_BACKOFF_MS  10   // Sampler pause after a failed conversion
+
+// Bus error retries
+#define ADS1115_RETRY_BACKOFF_MAX_US 10000 // Cap of the doubling retry backoff
+
+// Stuck-bus watchdog
+#define ADS1115_WATCHDOG_MIN_MS     100  // Shortest stall the watchdog acts on
+#define ADS1115_GENERAL_CALL_ADDR   0x00 // I2C general call address
+#define ADS1115_GENERAL_CALL_RESET  0x06 // General call reset command
+
+// Samples per second for each DR code
+static const unsigned int ads1115_data_rate_sps[] = { 8, 16, 32, 64, 128, 250, 475, 860 };
+static const unsigned int ads1015_data_rate_sps[] = { 128, 250, 490, 920, 1600, 2400, 3300, 3300 };
+
+#define ADS1115_PGA_FIXED 0x02 // +/-2.048V, the only range of parts without a PGA
+
+// Members of the ADS1x1x family. They share the register map; they differ in
+// resolution, data rates, and whether the multiplexer, PGA and comparator
+// (ALERT/RDY pin) are present.
+enum ads1115_variant_id {
+    ADS1013,
+    ADS1014,
+    ADS1015,
+    ADS1113,
+    ADS1114,
+    ADS1115,
+};
+
+struct ads1115_variant {
+    const char *name;
+    const unsigned int *data_rate_sps; // Samples per second for each DR code
+    u8 resolution_shift; // Right shift of the conversion register, 4 for 12-bit parts
+    u8 num_channels; // Logical channels, 1 without the multiplexer (AIN0 - AIN1 only)
+    bool has_pga; // Without it the range is fixed at +/-2.048V
+    bool has_comparator; // ALERT/RDY pin, needed for irq completion
+};
+
+static const struct ads1115_variant ads1115_variants[] = {
+    [ADS1013] = { "ads1013", ads1015_data_rate_sps, 4, 1, false, false },
+    [ADS1014] = { "ads1014", ads1015_data_rate_sps, 4, 1, true,  true  },
+    [ADS1015] = { "ads1015", ads1015_data_rate_sps, 4, 4, true,  true  },
+    [ADS1113] = { "ads1113", ads1115_data_rate_sps, 0, 1, false, false },
+    [ADS1114] = { "ads1114", ads1115_data_rate_sps, 0, 1, true,  true  },
+    [ADS1115] = { "ads1115", ads1115_data_rate_sps, 0, 4, true,  true  },
+};
+
+// Statistics
+#define ADS1115_HIST_BUCKETS    20   // log2 microsecond buckets, last one open-ended
+
+// I2C error classes counted separately
+enum ads1115_i2c_error {
+    ADS1115_ERR_NAK,      // -ENXIO, -EREMOTEIO: no ACK
+    ADS1115_ERR_TIMEOUT,  // -ETIMEDOUT
+    ADS1115_ERR_ARB_LOST, // -EAGAIN: arbitration lost
+    ADS1115_ERR_BUSY,     // -EBUSY: bus busy for too long
+    ADS1115_ERR_OTHER,
+    ADS1115_ERR_NUM,
+};
+
+static const char * const ads1115_i2c_error_names[ADS1115_ERR_NUM] = {
+    [ADS1115_ERR_NAK]      = "nak",
+    [ADS1115_ERR_TIMEOUT]  = "timeout",
+    [ADS1115_ERR_ARB_LOST] = "arb_lost",
+    [ADS1115_ERR_BUSY]     = "busy",
+    [ADS1115_ERR_OTHER]    = "other",
+};
+
+// Per-CPU counters, summed when read so the hot path never shares a cacheline
+struct ads1115_stats {
+    u64 conversions; // Successful conversions
+    u64 i2c_errors[ADS1115_ERR_NUM]; // Failed bus transfers by class
+    u64 retries; // Bus transfers repeated after an error
+    u64 recoveries; // Watchdog bus recoveries attempted
+    u64 ring_overruns; // Stream samples dropped on a full ring
+    u64 reader_wakeups; // Blocked readers woken by new samples
+    u64 settling_discards; // Continuous-mode conversions skipped after a MUX/PGA/DR switch
+    u64 conversions_skipped; // Continuous-mode results overwritten before they were read
+    u64 saturated_high[ADS1115_NUM_CHANNELS]; // Positive full-scale results per channel
+    u64 saturated_low[ADS1115_NUM_CHANNELS]; // Negative full-scale results per channel
+    u64 over_range[ADS1115_NUM_CHANNELS]; // Results at or beyond VDD + 0.3 V per channel
+    u64 read_latency[ADS1115_HIST_BUCKETS]; // ioctl call time or sample age at dequeue
+    u64 xfer_time[ADS1115_HIST_BUCKETS]; // Duration of each bus transfer
+};
+
+// How the driver learns that a conversion has finished
+enum ads1115_completion {
+    ADS1115_COMPLETE_SLEEP, // Sleep for the worst-case conversion time
+    ADS1115_COMPLETE_POLL,  // Sleep for the shortest conversion time, then poll the OS bit
+    ADS1115_COMPLETE_IRQ,   // Wait for the ALERT/RDY conversion-ready interrupt
+};
+
+static const char * const ads1115_completion_names[] = {
+    [ADS1115_COMPLETE_SLEEP] = "sleep",
+    [ADS1115_COMPLETE_POLL]  = "poll",
+    [ADS1115_COMPLETE_IRQ]   = "irq",
+};
+
+// Conversion settings of one logical channel
+struct ads1115_channel {
+    u8 mux; // MUX code, 4..7 are AIN0..AIN3 vs GND
+    u8 pga; // PGA code
+    u8 data_rate; // DR code for single reads
+    bool enabled; // Channel may be read and streamed
+    u8 last_pga; // PGA of the previous conversion, ADS1115_CODE_UNKNOWN before the first
+};
+
+// How the sampler drives the chip. Single-shot writes the config for every
+// sample; continuous writes it only when the input changes, but the
+// conversion in flight at that moment still belongs to the old input and is
+// discarded. auto picks whichever delivers more samples per second.
+enum ads1115_strategy {
+    ADS1115_STRATEGY_AUTO,
+    ADS1115_STRATEGY_SINGLE,
+    ADS1115_STRATEGY_CONTINUOUS,
+};
+
+static const char * const ads1115_strategy_names[] = {
+    [ADS1115_STRATEGY_AUTO] = "auto",
+    [ADS1115_STRATEGY_SINGLE] = "single",
+    [ADS1115_STRATEGY_CONTINUOUS] = "continuous",
+};
+
+#define ADS1115_MAX_CONTEXTS 8 // Streams sharing one chip
+#define ADS1115_MAX_SLOTS    (ADS1115_MAX_CONTEXTS * ADS1115_NUM_CHANNELS)
+
+// One conversion of the merged schedule
+struct ads1115_slot {
+    u8 channel;
+    u8 pga;
+    u8 data_rate;
+};
+
+// Acquisition context: one per open file, plus the device's autostart
+// stream. Each has its own channels, DR, gains, ring and watermark. The
+// sampler is the only producer of every ring and readers are serialised by
+// read_lock, so rings need no spinlock.
+struct ads1115_ctx {
+    struct ads1115_data *data;
+    struct list_head node; // In data->contexts while streaming
+    bool active; // Streaming, on data->contexts
+    struct ads1115_stream_config cfg; // Channels and DR, changed by the sampler while active
+    u8 pga[ADS1115_NUM_CHANNELS]; // Gain per channel
+    u16 gen; // Generation of cfg
+    struct ads1115_stream_reconfig staged; // Next config, picked up by the sampler
+    bool staged_pending; // staged holds a config not yet applied
+    u16 staged_gen; // Generation of the last staged config, wraps (see ads1115_uapi.h)
+    bool gap; // Next sample follows a bus recovery
+
+    struct mutex read_lock; // Serialises ring consumers
+    wait_queue_head_t read_wq; // Readers waiting for samples
+    struct ads1115_sample *ring; // Sample ring, NULL until the first stream
+    unsigned int ring_alloc; // Slots in ring
+    unsigned int ring_size; // Slots for the next stream, power of two
+    unsigned int watermark; // Samples buffered before readers are woken
+    unsigned int ring_head; // Next slot written by the sampler
+    unsigned int ring_tail; // Next slot consumed by readers
+    unsigned long ring_overruns; // Samples dropped on a full ring
+    u16 seq; // Next sample sequence number
+};
+
+// Per-chip state. The first chip is /dev/ads1115, further ones /dev/ads1115-N.
+// One sampler thread serves every streaming context. Open files keep it
+// alive after the chip is unbound; their operations then fail with -ENODEV.
+struct ads1115_data {
+    struct kref ref; // Held by the bound chip and by every open file
+    bool removed; // Chip unbound, set under stream_lock and lock
+    struct i2c_client *client; // I2C client for ADS1115
+    struct device *device; // Device node in /dev
+    struct cdev cdev; // Character device
+    int minor; // Minor number and device index
+    struct mutex lock; // Serialises conversions on the chip
+    const struct ads1115_variant *variant; // Family member
+    struct ads1115_channel chan[ADS1115_NUM_CHANNELS]; // Channel settings
+    enum ads1115_completion completion; // Conversion completion mode
+    struct completion conv_done; // Signalled by the ALERT/RDY interrupt
+    bool autostart; // Start streaming at probe
+    bool chip_ready; // Chip checked and set up, done at first conversion
+    bool irq_requested; // ALERT/RDY interrupt requested, irq completion possible
+    u64 probe_ns; // Time spent in probe
+    u64 chip_init_ns; // Time spent in the deferred chip setup
+    struct ads1115_stream_config autostart_cfg; // Stream started at probe
+
+    struct mutex stream_lock; // Serialises stream start/stop and the sampler's lifetime
+    spinlock_t ctx_lock; // Protects contexts and staged configs against the sampler
+    struct list_head contexts; // Streaming contexts
+    unsigned int num_contexts;
+    bool sched_dirty; // Contexts changed, rebuild the schedule at the next boundary
+    struct task_struct *sampler; // Sampler thread, NULL when nothing streams
+    struct ads1115_ctx shared; // Autostart stream, read by files without their own
+    unsigned int ring_size; // Ring slots of newly opened files
+    unsigned int watermark; // Watermark of newly opened files
+
+    u16 shadow_config; // Last config written, restored after a chip reset
+    u8 last_mux; // MUX of the previous conversion, ADS1115_CODE_UNKNOWN after a reset
+    enum ads1115_strategy strategy; // Stream strategy setting
+    bool continuous; // Strategy the running stream uses
+    u16 cont_config; // Config running in continuous mode, 0 when the chip is single-shot
+    u64 cont_deadline_ns; // Expected end of the next continuous conversion
+    u64 cont_counted_ns; // End of the last continuous conversion accounted for at the nominal rate
+    u64 xfer_avg_ns; // Running average of bus transfer time
+    u32 vdd_uv; // Supply voltage from the vdd regulator, 0 when unknown
+    u64 last_ok_ns; // Time of the last successful conversion
+    struct delayed_work watchdog; // Stuck-bus watchdog while streaming
+    u64 watchdog_timeout_ns; // Stall that triggers a recovery
+    u64 last_recovery_ns; // Time of the last recovery attempt
+    u64 stall_start_ns; // Last success before the stall being recovered
+    bool recovering; // Recovery attempted, no conversion since
+    u64 recovery_last_ns; // Stall duration of the last completed recovery
+    u64 recovery_max_ns; // Longest stall recovered from
+
+    struct ads1115_stats __percpu *stats; // Counters and histograms
+    struct dentry *debugfs; // debugfs directory
+};
 
 // Global variables
-static struct i2c_client *ads1115_client; // I2C client for ADS1115
 static struct class* ads1115_class = NULL; // Device class in sysfs
-static struct device* ads1115_device = NULL; // Device node in /dev
-static int major_number; // Major number for character device
+static dev_t ads1115_devt; // First device number of the chrdev region
+static DEFINE_IDA(ads1115_minors); // Allocated minor numbers
+static struct dentry *ads1115_debugfs; // debugfs root
+
+static unsigned int default_data_rate = ADS1115_DR_128SPS;
+module_param(default_data_rate, uint, 0444);
+MODULE_PARM_DESC(default_data_rate, "DR code of channels the firmware does not configure (0-7)");
+
+static unsigned int default_pga = ADS1115_PGA_4_096V;
+module_param(default_pga, uint, 0444);
+MODULE_PARM_DESC(default_pga, "PGA code of channels the firmware does not configure (0-5)");
+
+static unsigned int default_ring_size = ADS1115_RING_SIZE;
+module_param(default_ring_size, uint, 0444);
+MODULE_PARM_DESC(default_ring_size, "Stream ring slots of new devices (power of two, 16-65536)");
+
+static unsigned int retries = 2;
+module_param(retries, uint, 0644);
+MODULE_PARM_DESC(retries, "Retries of a failed bus transfer (NAK, timeout, busy, lost arbitration)");
+
+static unsigned int retry_backoff_us = 200;
+module_param(retry_backoff_us, uint, 0644);
+MODULE_PARM_DESC(retry_backoff_us, "Pause before the first retry, doubled for each further one");
+
+static unsigned int watchdog_periods = 20;
+module_param(watchdog_periods, uint, 0644);
+MODULE_PARM_DESC(watchdog_periods, "Stream periods without a conversion before bus recovery (0 = off)");
+
+static unsigned int ads1115_hist_bucket(u64 ns)
+{
+    u64 us = div_u64(ns, NSEC_PER_USEC);
+
+    return us ? min_t(unsigned int, ilog2(us), ADS1115_HIST_BUCKETS - 1) : 0;
+}
+
+// Account one bus transfer: its duration and, on failure, its error class
+static void ads1115_stats_xfer(struct ads1115_data *data, u64 start_ns, u64 end_ns, int ret)
+{
+    enum ads1115_i2c_error err;
+
+    this_cpu_inc(data->stats->xfer_time[ads1115_hist_bucket(end_ns - start_ns)]);
+    if (ret >= 0) {
+        // 1/8 weight, enough to follow a bus speed change within a few samples
+        WRITE_ONCE(data->xfer_avg_ns, data->xfer_avg_ns - (data->xfer_avg_ns >> 3) +
+                                      ((end_ns - start_ns) >> 3));
+        return;
+    }
+
+    switch (ret) {
+    case -ENXIO:
+    case -EREMOTEIO:
+        err = ADS1115_ERR_NAK;
+        break;
+    case -ETIMEDOUT:
+        err = ADS1115_ERR_TIMEOUT;
+        break;
+    case -EAGAIN:
+        err = ADS1115_ERR_ARB_LOST;
+        break;
+    case -EBUSY:
+        err = ADS1115_ERR_BUSY;
+        break;
+    default:
+        err = ADS1115_ERR_OTHER;
+        break;
+    }
+    this_cpu_inc(data->stats->i2c_errors[err]);
+}
+
+static void ads1115_stats_latency(struct ads1115_data *data, u64 ns)
+{
+    this_cpu_inc(data->stats->read_latency[ads1115_hist_bucket(ns)]);
+}
+
+// Sum the per-CPU counters into one snapshot
+static void ads1115_stats_read(struct ads1115_data *data, struct ads1115_stats *sum)
+{
+    struct ads1115_stats *s;
+    int cpu, i;
+
+    memset(sum, 0, sizeof(*sum));
+    for_each_possible_cpu(cpu) {
+        s = per_cpu_ptr(data->stats, cpu);
+        sum->conversions += s->conversions;
+        sum->ring_overruns += s->ring_overruns;
+        sum->reader_wakeups += s->reader_wakeups;
+        sum->retries += s->retries;
+        sum->recoveries += s->recoveries;
+        sum->settling_discards += s->settling_discards;
+        sum->conversions_skipped += s->conversions_skipped;
+        for (i = 0; i < ADS1115_NUM_CHANNELS; i++) {
+            sum->saturated_high[i] += s->saturated_high[i];
+            sum->saturated_low[i] += s->saturated_low[i];
+            sum->over_range[i] += s->over_range[i];
+        }
+        for (i = 0; i < ADS1115_ERR_NUM; i++)
+            sum->i2c_errors[i] += s->i2c_errors[i];
+        for (i = 0; i < ADS1115_HIST_BUCKETS; i++) {
+            sum->read_latency[i] += s->read_latency[i];
+            sum->xfer_time[i] += s->xfer_time[i];
+        }
+    }
+}
+
+// Conversion time for a DR code: nominal period plus 10% oscillator tolerance
+static unsigned int ads1115_conv_time_us(struct ads1115_data *data, unsigned int data_rate)
+{
+    return DIV_ROUND_UP(USEC_PER_SEC * 11, data->variant->data_rate_sps[data_rate] * 10) + 50;
+}
+
+// Bus errors that can clear by themselves, see Documentation/i2c/fault-codes.rst
+static bool ads1115_xfer_retryable(int ret)
+{
+    return ret == -ENXIO || ret == -EREMOTEIO || ret == -ETIMEDOUT ||
+           ret == -EAGAIN || ret == -EBUSY;
+}
+
+// One SMBus word transfer, retried with a doubling backoff on transient bus
+// errors. *t0 and *t1 bracket the last attempt.
+static s32 ads1115_xfer_word(struct ads1115_data *data, bool write, u8 reg, u16 val,
+                             u64 *t0, u64 *t1)
+{
+    unsigned int attempt, max_retries = READ_ONCE(retries);
+    unsigned int backoff = READ_ONCE(retry_backoff_us);
+    s32 ret;
+
+    for (attempt = 0; ; attempt++) {
+        *t0 = ktime_get_ns();
+        if (write)
+            ret = i2c_smbus_write_word_data(data->client, reg, val);
+        else
+            ret = i2c_smbus_read_word_data(data->client, reg);
+        *t1 = ktime_get_ns();
+        ads1115_stats_xfer(data, *t0, *t1, ret);
+
+        if (ret >= 0 || attempt >= max_retries || !ads1115_xfer_retryable(ret))
+            return ret;
+
+        this_cpu_inc(data->stats->retries);
+        if (backoff)
+            usleep_range(backoff, backoff + backoff / 4);
+        backoff = min(backoff * 2, (unsigned int)ADS1115_RETRY_BACKOFF_MAX_US);
+    }
+}
+
+// ALERT/RDY as conversion-ready pin: high threshold MSB set, low threshold
+// MSB clear. The pin pulses at the end of each conversion.
+static int ads1115_setup_rdy(struct ads1115_data *data)
+{
+    int ret;
+
+    ret = i2c_smbus_write_word_data(data->client, ADS1115_REG_POINTER_LO_THRESH, swab16(0x0000));
+    if (ret < 0)
+        return ret;
+    return i2c_smbus_write_word_data(data->client, ADS1115_REG_POINTER_HI_THRESH, swab16(0x8000));
+}
+
+static irqreturn_t ads1115_irq_handler(int irq, void *dev_id)
+{
+    struct ads1115_data *data = dev_id;
+
+    complete(&data->conv_done);
+    return IRQ_HANDLED;
+}
+
+static u16 ads1115_channel_config(struct ads1115_data *data, unsigned int channel,
+                                  unsigned int pga, unsigned int data_rate)
+{
+    const struct ads1115_channel *chan = &data->chan[channel];
+    u16 config = ADS1115_CONFIG_BASE | (chan->mux << ADS1115_CONFIG_MUX_OFFSET) |
+                 (pga << ADS1115_CONFIG_PGA_OFFSET) | (data_rate << ADS1115_CONFIG_DR_OFFSET);
+
+    // COMP_QUE 00 asserts RDY after every conversion
+    if (data->completion != ADS1115_COMPLETE_IRQ)
+        config |= ADS1115_CONFIG_COMP_QUE_OFF;
+    return config;
+}
+
+// Wait until the conversion started by the last config write is done
+static int ads1115_wait_conversion(struct ads1115_data *data, unsigned int data_rate)
+{
+    unsigned int wait_us = ads1115_conv_time_us(data, data_rate);
+    unsigned int min_us;
+    u64 t0, t1, deadline;
+    s32 ret;
+
+    switch (data->completion) {
+    case ADS1115_COMPLETE_IRQ:
+        if (!wait_for_completion_timeout(&data->conv_done, usecs_to_jiffies(wait_us) + 1))
+            return -ETIMEDOUT;
+        return 0;
+
+    case ADS1115_COMPLETE_POLL:
+        // The oscillator may run 10% fast, start polling at 90% of nominal
+        min_us = USEC_PER_SEC * 9 / (data->variant->data_rate_sps[data_rate] * 10);
+        deadline = ktime_get_ns() + (u64)wait_us * NSEC_PER_USEC;
+        usleep_range(min_us, min_us + ADS1115_POLL_INTERVAL_US);
+        for (;;) {
+            ret = ads1115_xfer_word(data, false, ADS1115_REG_POINTER_CONFIG, 0, &t0, &t1);
+            if (ret < 0)
+                return ret;
+            if (swab16((u16)ret) & ADS1115_CONFIG_OS_SINGLE) // OS reads 1 when idle
+                return 0;
+            if (t1 >= deadline)
+                return -ETIMEDOUT;
+            usleep_range(ADS1115_POLL_INTERVAL_US, 2 * ADS1115_POLL_INTERVAL_US);
+        }
+
+    default:
+        usleep_range(wait_us, wait_us + wait_us / 8);
+        return 0;
+    }
+}
+
+// Deferred from probe so boot does not wait on the bus: check that the chip
+// answers with a sane config register, then set up ALERT/RDY for irq
+// completion. Called with data->lock held.
+static int ads1115_chip_init(struct ads1115_data *data)
+{
+    struct i2c_client *client = data->client;
+    u64 start = ktime_get_ns();
+    int ret;
+
+    ret = i2c_smbus_read_word_data(client, ADS1115_REG_POINTER_CONFIG);
+    if (ret < 0) {
+        dev_err_ratelimited(&client->dev, "Chip not responding: %d\n", ret);
+        return ret;
+    }
+    // Power-on value 0x8583 unless someone configured the chip since
+    dev_dbg(&client->dev, "Config register 0x%04x\n", swab16((u16)ret));
+
+    if (data->completion == ADS1115_COMPLETE_IRQ) {
+        ret = ads1115_setup_rdy(data);
+        if (ret < 0) {
+            dev_err_ratelimited(&client->dev, "ALERT/RDY setup failed: %d\n", ret);
+            return ret;
+        }
+    }
+
+    data->chip_init_ns = ktime_get_ns() - start;
+    data->chip_ready = true;
+    return 0;
+}
+
+// Full-scale range in microvolts for each PGA code
+static const unsigned int ads1115_fsr_uv[] = { 6144000, 4096000, 2048000, 1024000, 512000, 256000 };
+
+// Range flags of a result, counted per channel. Saturation is the extreme
+// code of the part; over-range is an input at or beyond the absolute maximum
+// of VDD + 0.3 V, needs the supply voltage and only matters for the ranges
+// wider than that.
+static u8 ads1115_range_flags(struct ads1115_data *data, unsigned int channel, unsigned int pga,
+                             s16 value)
+{
+    unsigned int bits = 15 - data->variant->resolution_shift;
+    u8 flags = 0;
+
+    if (value == S16_MAX >> data->variant->resolution_shift) {
+        flags |= ADS1115_SAMPLE_SAT_HIGH;
+        this_cpu_inc(data->stats->saturated_high[channel]);
+    } else if (value == S16_MIN >> data->variant->resolution_shift) {
+        flags |= ADS1115_SAMPLE_SAT_LOW;
+        this_cpu_inc(data->stats->saturated_low[channel]);
+    }
+    if (data->vdd_uv &&
+        ((s64)abs(value) * ads1115_fsr_uv[pga] >> bits) >=
+        (s64)data->vdd_uv + ADS1115_OVER_RANGE_MARGIN_UV) {
+        flags |= ADS1115_SAMPLE_OVER_RANGE;
+        this_cpu_inc(data->stats->over_range[channel]);
+    }
+    return flags;
+}
+
+// MUX/PGA change flags of a conversion about to start on channel
+static u8 ads1115_switch_flags(struct ads1115_data *data, struct ads1115_channel *chan, u8 pga)
+{
+    u8 flags = 0;
+
+    if (data->last_mux != chan->mux && data->last_mux != ADS1115_CODE_UNKNOWN)
+        flags |= ADS1115_SAMPLE_MUX_SWITCH;
+    if (chan->last_pga != pga && chan->last_pga != ADS1115_CODE_UNKNOWN)
+        flags |= ADS1115_SAMPLE_GAIN_CHANGED;
+    data->last_mux = chan->mux;
+    chan->last_pga = pga;
+    return flags;
+}
 
-// Read ADC value from a channel
-static s16 ads1115_read_single_channel(struct i2c_client *client, u16 mux_config)
+// Read ADC value from a channel. flags, when not NULL, gets the
+// ADS1115_SAMPLE_* bits describing the result.
+static int ads1115_read_single_channel(struct ads1115_data *data, unsigned int channel,
+                                       unsigned int pga, unsigned int data_rate, s16 *value,
+                                       u8 *flags)
 {
+    struct ads1115_channel *chan = &data->chan[channel];
+    u8 conv_flags = 0;
+    struct i2c_client *client = data->client;
     u16 config_val;
-    s16 raw_val;
+    u64 t0, t1;
     int ret;
 
-    if (!client) {
-        printk(KERN_ERR DRIVER_NAME ": Invalid I2C client\n");
-        return -EIO;
+    if (unlikely(!data->chip_ready)) {
+        ret = ads1115_chip_init(data);
+        if (ret < 0)
+            return ret;
     }
 
-    config_val = ADS1115_CONFIG_BASE | mux_config;
+    config_val = ads1115_channel_config(data, channel, pga, data_rate);
 
-    ret = i2c_smbus_write_word_data(client, ADS1115_REG_POINTER_CONFIG, swab16(config_val));
+    if (data->completion == ADS1115_COMPLETE_IRQ)
+        reinit_completion(&data->conv_done);
+    data->shadow_config = config_val;
+    ret = ads1115_xfer_word(data, true, ADS1115_REG_POINTER_CONFIG, swab16(config_val), &t0, &t1);
     if (ret < 0) {
-        dev_err(&client->dev, "Config write error: %d\n", ret);
+        dev_err_ratelimited(&client->dev, "Config write error: %d\n", ret);
         return ret;
     }
+    trace_ads1115_conv_start(client, channel, config_val, t1 - t0);
+    data->cont_config = 0; // A single-shot config stops continuous conversions
+    conv_flags = ads1115_switch_flags(data, chan, pga);
 
-    msleep(15); // Wait for ADC conversion (128SPS)
+    ret = ads1115_wait_conversion(data, data_rate);
+    if (ret < 0) {
+        dev_err_ratelimited(&client->dev, "Conversion did not complete: %d\n", ret);
+        return ret;
+    }
+
+    trace_ads1115_conv_ready(client, channel, ktime_get_ns() - t1);
+
+    // The SMBus word read sets the pointer itself, no separate pointer write
+    ret = ads1115_xfer_word(data, false, ADS1115_REG_POINTER_CONVERSION, 0, &t0, &t1);
+    if (ret < 0) {
+        trace_ads1115_result_read(client, channel, 0, t1 - t0, ret);
+        dev_err_ratelimited(&client->dev, "Read error: %d\n", ret);
+        return ret;
+    }
+
+    // 12-bit parts left-justify the result, the shift keeps the sign
+    *value = (s16)swab16((u16)ret) >> data->variant->resolution_shift;
+    WRITE_ONCE(data->last_ok_ns, t1);
+    this_cpu_inc(data->stats->conversions);
+    conv_flags |= ads1115_range_flags(data, channel, pga, *value);
+    if (flags)
+        *flags = conv_flags;
+    trace_ads1115_result_read(client, channel, *value, t1 - t0, 0);
+    return 0;
+}
+
+// Continuous-mode read for the sampler. The config is only written when the
+// channel settings change; the conversion in flight at that point finishes
+// with the old input, so the next result is skipped and the one after is
+// returned. Results are picked up on a fixed schedule of conversion times,
+// which include the 10% oscillator margin, so a result is never read twice;
+// a chip running at its nominal rate overwrites about one result in eleven
+// unread, and those are counted as skipped.
+// Completion is always timed: RDY pulses of unread conversions would leave
+// the completion out of step. Called with data->lock held.
+static int ads1115_read_continuous(struct ads1115_data *data, unsigned int channel,
+                                   unsigned int pga, unsigned int data_rate, s16 *value, u8 *flags)
+{
+    struct i2c_client *client = data->client;
+    struct ads1115_channel *chan = &data->chan[channel];
+    u16 config_val = ads1115_channel_config(data, channel, pga, data_rate) &
+                     ~(ADS1115_CONFIG_OS_SINGLE | ADS1115_CONFIG_MODE_SINGLE);
+    u64 period_ns = (u64)ads1115_conv_time_us(data, data_rate) * NSEC_PER_USEC;
+    u32 nominal_ns = NSEC_PER_SEC / data->variant->data_rate_sps[data_rate];
+    u8 conv_flags = 0;
+    u64 t0, t1, now, done;
+    int ret;
+
+    if (unlikely(!data->chip_ready)) {
+        ret = ads1115_chip_init(data);
+        if (ret < 0)
+            return ret;
+    }
 
-    ret = i2c_smbus_write_byte(client, ADS1115_REG_POINTER_CONVERSION);
+    if (config_val != data->cont_config) {
+        data->shadow_config = config_val;
+        ret = ads1115_xfer_word(data, true, ADS1115_REG_POINTER_CONFIG, swab16(config_val), &t0, &t1);
+        if (ret < 0) {
+            data->cont_config = 0;
+            dev_err_ratelimited(&client->dev, "Config write error: %d\n", ret);
+            return ret;
+        }
+        trace_ads1115_conv_start(client, channel, config_val, t1 - t0);
+        conv_flags = ads1115_switch_flags(data, chan, pga);
+
+        // From single-shot the first conversion starts with the write
+        if (data->cont_config) {
+            t1 += period_ns;
+            this_cpu_inc(data->stats->settling_discards);
+        }
+        data->cont_config = config_val;
+        data->cont_deadline_ns = t1;
+        data->cont_counted_ns = t1;
+    }
+
+    data->cont_deadline_ns += period_ns;
+    now = ktime_get_ns();
+    if (data->cont_deadline_ns > now) {
+        unsigned int wait_us = div_u64(data->cont_deadline_ns - now, NSEC_PER_USEC);
+
+        usleep_range(wait_us, wait_us + ADS1115_POLL_INTERVAL_US);
+    } else {
+        data->cont_deadline_ns = now; // Fell behind, the register holds the newest result
+    }
+    trace_ads1115_conv_ready(client, channel, period_ns);
+
+    ret = ads1115_xfer_word(data, false, ADS1115_REG_POINTER_CONVERSION, 0, &t0, &t1);
     if (ret < 0) {
-        dev_err(&client->dev, "Conversion register error: %d\n", ret);
+        trace_ads1115_result_read(client, channel, 0, t1 - t0, ret);
+        dev_err_ratelimited(&client->dev, "Read error: %d\n", ret);
         return ret;
     }
 
-    raw_val = i2c_smbus_read_word_data(client, ADS1115_REG_POINTER_CONVERSION);
-    if (raw_val < 0) {
-        dev_err(&client->dev, "Read error: %d\n", raw_val);
-        return raw_val;
+    // Conversions the chip finished since the last read, all but one unread
+    done = div_u64(t0 - data->cont_counted_ns, nominal_ns);
+    if (done > 1)
+        this_cpu_add(data->stats->conversions_skipped, done - 1);
+    data->cont_counted_ns += done * nominal_ns;
+
+    *value = (s16)swab16((u16)ret) >> data->variant->resolution_shift;
+    WRITE_ONCE(data->last_ok_ns, t1);
+    this_cpu_inc(data->stats->conversions);
+    *flags = conv_flags | ads1115_range_flags(data, channel, pga, *value);
+    trace_ads1115_result_read(client, channel, *value, t1 - t0, 0);
+    return 0;
+}
+
+// Put a continuously converting chip back into single-shot power-down.
+// Called with data->lock held.
+static int ads1115_stop_continuous(struct ads1115_data *data)
+{
+    u16 config_val = data->cont_config | ADS1115_CONFIG_MODE_SINGLE;
+
+    if (!data->cont_config)
+        return 0;
+    data->cont_config = 0;
+    data->shadow_config = config_val;
+    return i2c_smbus_write_word_data(data->client, ADS1115_REG_POINTER_CONFIG, swab16(config_val));
+}
+
+// Sampler strategy for a schedule of conversions. Per sample, single-shot
+// costs a config write, a conversion and a read. Continuous costs a
+// conversion for a single entry (the read overlaps the next conversion), and
+// a write, a discarded conversion, a conversion and a read for several.
+static bool ads1115_use_continuous(struct ads1115_data *data, unsigned int conversions,
+                                   unsigned int data_rate)
+{
+    u64 conv_ns = (u64)ads1115_conv_time_us(data, data_rate) * NSEC_PER_USEC;
+    u64 xfer_ns = READ_ONCE(data->xfer_avg_ns);
+    u64 single_ns = 2 * xfer_ns + conv_ns, cont_ns;
+
+    switch (READ_ONCE(data->strategy)) {
+    case ADS1115_STRATEGY_SINGLE:
+        return false;
+    case ADS1115_STRATEGY_CONTINUOUS:
+        return true;
+    default:
+        break;
     }
 
-    return swab16(raw_val);
+    cont_ns = conversions == 1 ? max(conv_ns, xfer_ns) : 2 * xfer_ns + 2 * conv_ns;
+    return cont_ns < single_ns;
+}
+
+// Unstick the bus and the chip: adapter bus recovery (SCL pulses and a STOP)
+// where the adapter supports it, a general call reset, then the last config
+// written. The reset reaches every chip on the bus; other ads1115 chips
+// rewrite their full config with each conversion, so they only lose the
+// conversion in flight. Called with data->lock held.
+static int ads1115_recover(struct ads1115_data *data)
+{
+    struct i2c_adapter *adap = data->client->adapter;
+    int ret;
+
+    if (adap->bus_recovery_info) {
+        i2c_lock_bus(adap, I2C_LOCK_ROOT_ADAPTER);
+        ret = i2c_recover_bus(adap);
+        i2c_unlock_bus(adap, I2C_LOCK_ROOT_ADAPTER);
+        if (ret)
+            dev_warn_ratelimited(&data->client->dev, "Bus recovery failed: %d\n", ret);
+    }
+
+    ret = i2c_smbus_xfer(adap, ADS1115_GENERAL_CALL_ADDR, 0, I2C_SMBUS_WRITE,
+                         ADS1115_GENERAL_CALL_RESET, I2C_SMBUS_BYTE, NULL);
+    if (ret < 0)
+        return ret;
+
+    // The reset also cleared the thresholds that make ALERT/RDY a ready pin
+    if (data->completion == ADS1115_COMPLETE_IRQ) {
+        ret = ads1115_setup_rdy(data);
+        if (ret < 0)
+            return ret;
+    }
+
+    return i2c_smbus_write_word_data(data->client, ADS1115_REG_POINTER_CONFIG,
+                                     swab16(data->shadow_config & ~ADS1115_CONFIG_OS_SINGLE));
+}
+
+// Runs every quarter timeout while streaming. Once no conversion has
+// succeeded for the timeout, recover, and again every further timeout until
+// the sampler gets a result.
+static void ads1115_watchdog_fn(struct work_struct *work)
+{
+    struct ads1115_data *data = container_of(to_delayed_work(work), struct ads1115_data, watchdog);
+    u64 now = ktime_get_ns(), last_ok = READ_ONCE(data->last_ok_ns);
+    int ret;
+
+    if (now - max(last_ok, data->last_recovery_ns) >= data->watchdog_timeout_ns) {
+        if (!smp_load_acquire(&data->recovering)) {
+            data->stall_start_ns = last_ok;
+            smp_store_release(&data->recovering, true);
+        }
+        dev_warn_ratelimited(&data->client->dev, "No conversion for %llu ms, recovering the bus\n",
+                             div_u64(now - last_ok, NSEC_PER_MSEC));
+
+        mutex_lock(&data->lock);
+        ret = ads1115_recover(data);
+        data->last_mux = ADS1115_CODE_UNKNOWN;
+        data->cont_config = 0; // Rewritten by the sampler
+        mutex_unlock(&data->lock);
+        if (ret < 0)
+            dev_warn_ratelimited(&data->client->dev, "Chip reset failed: %d\n", ret);
+
+        data->last_recovery_ns = ktime_get_ns();
+        this_cpu_inc(data->stats->recoveries);
+    }
+
+    schedule_delayed_work(&data->watchdog,
+                          max(nsecs_to_jiffies(data->watchdog_timeout_ns / 4), 1UL));
+}
+
+// First conversion after a recovery: record how long the stream was stalled
+static void ads1115_recovery_done(struct ads1115_data *data)
+{
+    u64 stalled = READ_ONCE(data->last_ok_ns) - data->stall_start_ns;
+
+    WRITE_ONCE(data->recovery_last_ns, stalled);
+    if (stalled > data->recovery_max_ns)
+        WRITE_ONCE(data->recovery_max_ns, stalled);
+    WRITE_ONCE(data->recovering, false);
+    dev_info(&data->client->dev, "Recovered after %llu ms\n", div_u64(stalled, NSEC_PER_MSEC));
+}
+
+static u64 ads1115_watchdog_timeout(u64 pass_us, unsigned int periods)
+{
+    // Expected time for one pass over the schedule, times watchdog_periods
+    return max_t(u64, (u64)periods * pass_us * NSEC_PER_USEC, ADS1115_WATCHDOG_MIN_MS * NSEC_PER_MSEC);
+}
+
+// Take the staged config of a context. Called by the sampler between
+// conversions, so every sample is taken entirely under one generation.
+static void ads1115_ctx_apply_staged(struct ads1115_ctx *ctx)
+{
+    const struct ads1115_stream_reconfig *rc = &ctx->staged;
+    int ch;
+
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++)
+        if (rc->pga[ch] != ADS1115_PGA_KEEP)
+            ctx->pga[ch] = rc->pga[ch];
+    ctx->cfg.channel_mask = rc->channel_mask;
+    ctx->cfg.data_rate = rc->data_rate;
+    ctx->gen = rc->generation;
+    ctx->staged_pending = false;
+    trace_ads1115_stream_reconfig(ctx->data->client, ctx->gen, ctx->cfg.channel_mask,
+                                  ctx->cfg.data_rate);
+}
+
+static bool ads1115_ctx_wants(const struct ads1115_ctx *ctx, const struct ads1115_slot *slot)
+{
+    return (ctx->cfg.channel_mask & BIT(slot->channel)) && ctx->cfg.data_rate == slot->data_rate &&
+           ctx->pga[slot->channel] == slot->pga;
+}
+
+// Merge the streaming contexts into one conversion schedule: every distinct
+// (channel, PGA, DR) once per pass, in channel order. Contexts asking for the
+// same settings share the conversion. Returns the number of entries.
+static unsigned int ads1115_build_schedule(struct ads1115_data *data, struct ads1115_slot *sched)
+{
+    unsigned int periods = READ_ONCE(watchdog_periods);
+    unsigned int n = 0, i, ch, slowest = 0;
+    struct ads1115_slot slot;
+    struct ads1115_ctx *ctx;
+    u64 pass_us = 0;
+
+    spin_lock(&data->ctx_lock);
+    WRITE_ONCE(data->sched_dirty, false);
+    list_for_each_entry(ctx, &data->contexts, node)
+        if (ctx->staged_pending)
+            ads1115_ctx_apply_staged(ctx);
+
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++) {
+        list_for_each_entry(ctx, &data->contexts, node) {
+            if (!(ctx->cfg.channel_mask & BIT(ch)))
+                continue;
+            slot.channel = ch;
+            slot.pga = ctx->pga[ch];
+            slot.data_rate = ctx->cfg.data_rate;
+            for (i = 0; i < n; i++)
+                if (!memcmp(&sched[i], &slot, sizeof(slot)))
+                    break;
+            if (i == n && n < ADS1115_MAX_SLOTS)
+                sched[n++] = slot;
+        }
+    }
+    spin_unlock(&data->ctx_lock);
+
+    // The strategy is costed at the slowest rate in the schedule, where the
+    // settling conversion continuous mode discards on each switch costs most
+    for (i = 0; i < n; i++) {
+        pass_us += ads1115_conv_time_us(data, sched[i].data_rate);
+        if (sched[i].data_rate < sched[slowest].data_rate)
+            slowest = i;
+    }
+    if (periods)
+        WRITE_ONCE(data->watchdog_timeout_ns, ads1115_watchdog_timeout(pass_us, periods));
+    data->continuous = n && ads1115_use_continuous(data, n, sched[slowest].data_rate);
+    dev_dbg(&data->client->dev, "Schedule of %u conversions, %s\n", n,
+            data->continuous ? "continuous" : "single-shot");
+    return n;
+}
+
+// Store one result in a context's ring. Called with ctx_lock held.
+static void ads1115_ctx_push(struct ads1115_ctx *ctx, unsigned int ch, s16 value, u8 flags, u64 now)
+{
+    struct ads1115_data *data = ctx->data;
+    unsigned int ring_mask = ctx->ring_alloc - 1;
+    unsigned int head = ctx->ring_head, tail = smp_load_acquire(&ctx->ring_tail);
+    struct ads1115_sample *slot;
+
+    if (head - tail > ring_mask) {
+        ctx->ring_overruns++;
+        this_cpu_inc(data->stats->ring_overruns);
+        trace_ads1115_sample_enqueue(data->client, ch, ctx->seq++, head - tail, true);
+        return;
+    }
+
+    slot = &ctx->ring[head & ring_mask];
+    slot->timestamp_ns = now;
+    slot->value = value;
+    slot->channel = ch;
+    slot->flags = flags;
+    slot->seq = ctx->seq++;
+    slot->generation = ctx->gen;
+    smp_store_release(&ctx->ring_head, head + 1);
+    trace_ads1115_sample_enqueue(data->client, ch, slot->seq, head + 1 - tail, false);
+    if (head + 1 - tail >= READ_ONCE(ctx->watermark))
+        wake_up_interruptible(&ctx->read_wq);
+}
+
+// Sampler thread: runs the merged schedule round-robin and hands each result
+// to every context that asked for it
+static int ads1115_sampler_fn(void *arg)
+{
+    struct ads1115_data *data = arg;
+    struct ads1115_slot sched[ADS1115_MAX_SLOTS];
+    unsigned int nslots = 0, next = 0;
+    const struct ads1115_slot *slot;
+    struct ads1115_ctx *ctx;
+    bool gap = false;
+    u8 flags;
+    s16 value;
+    u64 now;
+    int ret;
+
+    while (!kthread_should_stop()) {
+        if (READ_ONCE(data->sched_dirty)) {
+            nslots = ads1115_build_schedule(data, sched);
+            next = 0;
+        }
+        if (!nslots) {
+            msleep(ADS1115_ERR_BACKOFF_MS); // Last context leaving, about to be stopped
+            continue;
+        }
+        slot = &sched[next];
+        next = next + 1 < nslots ? next + 1 : 0;
+
+        mutex_lock(&data->lock);
+        if (data->continuous)
+            ret = ads1115_read_continuous(data, slot->channel, slot->pga, slot->data_rate,
+                                          &value, &flags);
+        else
+            ret = ads1115_read_single_channel(data, slot->channel, slot->pga, slot->data_rate,
+                                              &value, &flags);
+        mutex_unlock(&data->lock);
+        if (ret < 0) {
+            msleep(ADS1115_ERR_BACKOFF_MS);
+            continue;
+        }
+        if (smp_load_acquire(&data->recovering)) {
+            ads1115_recovery_done(data);
+            gap = true;
+        }
+
+        now = ktime_get_ns();
+        spin_lock(&data->ctx_lock);
+        list_for_each_entry(ctx, &data->contexts, node) {
+            if (gap)
+                ctx->gap = true;
+            if (!ads1115_ctx_wants(ctx, slot))
+                continue;
+            ads1115_ctx_push(ctx, slot->channel, value,
+                             flags | (ctx->gap ? ADS1115_SAMPLE_GAP : 0), now);
+            ctx->gap = false;
+        }
+        spin_unlock(&data->ctx_lock);
+        gap = false;
+    }
+
+    // Leave the chip powered down, as single-shot mode does between reads
+    mutex_lock(&data->lock);
+    ret = ads1115_stop_continuous(data);
+    mutex_unlock(&data->lock);
+    if (ret < 0)
+        dev_warn(&data->client->dev, "Stopping continuous conversions failed: %d\n", ret);
+
+    return 0;
+}
+
+static u32 ads1115_enabled_mask(struct ads1115_data *data)
+{
+    u32 mask = 0;
+    int ch;
+
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++)
+        if (data->chan[ch].enabled)
+            mask |= BIT(ch);
+    return mask;
+}
+
+static void ads1115_ctx_init(struct ads1115_ctx *ctx, struct ads1115_data *data)
+{
+    ctx->data = data;
+    INIT_LIST_HEAD(&ctx->node);
+    mutex_init(&ctx->read_lock);
+    init_waitqueue_head(&ctx->read_wq);
+    ctx->ring_size = READ_ONCE(data->ring_size);
+    ctx->watermark = min(READ_ONCE(data->watermark), ctx->ring_size);
+}
+
+// Add a context to the schedule, starting the sampler for the first one.
+// The context's channels take the device's current gains.
+static int ads1115_stream_start(struct ads1115_ctx *ctx, const struct ads1115_stream_config *cfg)
+{
+    struct ads1115_data *data = ctx->data;
+    struct ads1115_sample *ring = NULL;
+    struct task_struct *task;
+    unsigned int periods;
+    int ch, ret = 0;
+
+    if (!cfg->channel_mask || cfg->channel_mask & ~GENMASK(ADS1115_NUM_CHANNELS - 1, 0) ||
+        cfg->channel_mask & ~ads1115_enabled_mask(data) || cfg->data_rate > ADS1115_DR_MAX)
+        return -EINVAL;
+
+    mutex_lock(&data->stream_lock);
+    if (data->removed) {
+        ret = -ENODEV;
+        goto out;
+    }
+    if (ctx->active) {
+        ret = -EBUSY;
+        goto out;
+    }
+    if (data->num_contexts == ADS1115_MAX_CONTEXTS) {
+        ret = -EBUSY;
+        goto out;
+    }
+
+    // Keep the ring between streams, leftovers are dropped
+    mutex_lock(&ctx->read_lock);
+    if (!ctx->ring || ctx->ring_alloc != ctx->ring_size) {
+        ring = kvcalloc(ctx->ring_size, sizeof(*ring), GFP_KERNEL);
+        if (!ring) {
+            mutex_unlock(&ctx->read_lock);
+            ret = -ENOMEM;
+            goto out;
+        }
+        swap(ctx->ring, ring);
+        ctx->ring_alloc = ctx->ring_size;
+    }
+    ctx->ring_head = 0;
+    ctx->ring_tail = 0;
+    mutex_unlock(&ctx->read_lock);
+    kvfree(ring);
+
+    ctx->cfg = *cfg;
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++)
+        ctx->pga[ch] = data->chan[ch].pga;
+    ctx->ring_overruns = 0;
+    ctx->seq = 0;
+    ctx->gen = 0;
+    ctx->staged_gen = 0;
+    ctx->staged_pending = false;
+    ctx->gap = false;
+
+    if (!data->sampler) {
+        data->last_ok_ns = ktime_get_ns();
+        data->last_recovery_ns = 0;
+        data->recovering = false;
+
+        task = kthread_create(ads1115_sampler_fn, data, "ads1115-sampler/%d", data->minor);
+        if (IS_ERR(task)) {
+            ret = PTR_ERR(task);
+            goto out;
+        }
+        data->sampler = task;
+    }
+
+    spin_lock(&data->ctx_lock);
+    list_add_tail(&ctx->node, &data->contexts);
+    data->num_contexts++;
+    WRITE_ONCE(ctx->active, true);
+    WRITE_ONCE(data->sched_dirty, true);
+    spin_unlock(&data->ctx_lock);
+
+    if (data->num_contexts == 1) {
+        wake_up_process(data->sampler);
+
+        periods = READ_ONCE(watchdog_periods);
+        if (periods) {
+            data->watchdog_timeout_ns =
+                ads1115_watchdog_timeout((u64)hweight32(cfg->channel_mask) *
+                                         ads1115_conv_time_us(data, cfg->data_rate), periods);
+            schedule_delayed_work(&data->watchdog, nsecs_to_jiffies(data->watchdog_timeout_ns));
+        }
+    }
+out:
+    mutex_unlock(&data->stream_lock);
+    return ret;
+}
+
+// Stage a config for a running context. A second call before the sampler
+// reaches a conversion boundary replaces the first.
+static int ads1115_stream_reconfig(struct ads1115_ctx *ctx, struct ads1115_stream_reconfig *rc)
+{
+    struct ads1115_data *data = ctx->data;
+    int ch, ret = 0;
+
+    if (!rc->channel_mask || rc->channel_mask & ~GENMASK(ADS1115_NUM_CHANNELS - 1, 0) ||
+        rc->channel_mask & ~ads1115_enabled_mask(data) || rc->data_rate > ADS1115_DR_MAX ||
+        rc->reserved)
+        return -EINVAL;
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++) {
+        if (rc->pga[ch] == ADS1115_PGA_KEEP)
+            continue;
+        if (rc->pga[ch] > ADS1115_PGA_MAX)
+            return -EINVAL;
+        if (!data->variant->has_pga)
+            return -EOPNOTSUPP;
+    }
+
+    spin_lock(&data->ctx_lock);
+    if (!ctx->active) {
+        ret = -EINVAL; // No stream to reconfigure
+    } else {
+        rc->generation = ++ctx->staged_gen;
+        ctx->staged = *rc;
+        ctx->staged_pending = true;
+        WRITE_ONCE(data->sched_dirty, true);
+    }
+    spin_unlock(&data->ctx_lock);
+    return ret;
+}
+
+// Stop the sampler once no context is left. Called with stream_lock held.
+static void ads1115_sampler_stop(struct ads1115_data *data)
+{
+    if (!data->sampler || data->num_contexts)
+        return;
+    cancel_delayed_work_sync(&data->watchdog);
+    kthread_stop(data->sampler);
+    data->sampler = NULL;
+}
+
+static void ads1115_stream_stop(struct ads1115_ctx *ctx)
+{
+    struct ads1115_data *data = ctx->data;
+
+    mutex_lock(&data->stream_lock);
+    if (ctx->active) {
+        spin_lock(&data->ctx_lock);
+        list_del_init(&ctx->node);
+        data->num_contexts--;
+        WRITE_ONCE(ctx->active, false);
+        WRITE_ONCE(data->sched_dirty, true);
+        spin_unlock(&data->ctx_lock);
+        ads1115_sampler_stop(data);
+        if (ctx->ring_overruns)
+            dev_warn(&data->client->dev, "Stream dropped %lu samples\n", ctx->ring_overruns);
+    }
+    mutex_unlock(&data->stream_lock);
+    wake_up_interruptible(&ctx->read_wq); // Let blocked readers see end of stream
+}
+
+// Device going away: end every stream, open files then see end of stream
+static void ads1115_stream_stop_all(struct ads1115_data *data)
+{
+    struct ads1115_ctx *ctx, *tmp;
+
+    mutex_lock(&data->stream_lock);
+    spin_lock(&data->ctx_lock);
+    list_for_each_entry_safe(ctx, tmp, &data->contexts, node) {
+        list_del_init(&ctx->node);
+        WRITE_ONCE(ctx->active, false);
+        wake_up_interruptible(&ctx->read_wq);
+    }
+    data->num_contexts = 0;
+    spin_unlock(&data->ctx_lock);
+    ads1115_sampler_stop(data);
+    mutex_unlock(&data->stream_lock);
+}
+
+static bool ads1115_ring_empty(struct ads1115_ctx *ctx)
+{
+    return smp_load_acquire(&ctx->ring_head) == ctx->ring_tail;
+}
+
+static bool ads1115_ring_ready(struct ads1115_ctx *ctx, unsigned int need)
+{
+    return smp_load_acquire(&ctx->ring_head) - ctx->ring_tail >= need;
+}
+
+// Context read by a file: its own once it has streamed, else the shared
+// autostart stream
+static struct ads1115_ctx *ads1115_file_ctx(struct file *file)
+{
+    struct ads1115_ctx *ctx = file->private_data;
+
+    return ctx->ring ? ctx : &ctx->data->shared;
+}
+
+// Ring size and watermark of a context, the ring size only while stopped
+static int ads1115_set_buffer(struct ads1115_ctx *ctx, const struct ads1115_buffer_config *buf)
+{
+    struct ads1115_data *data = ctx->data;
+    unsigned int size = buf->ring_size ? buf->ring_size : ctx->ring_size;
+    int ret = 0;
+
+    if (!is_power_of_2(size) || size < ADS1115_RING_MIN || size > ADS1115_RING_MAX ||
+        !buf->watermark || buf->watermark > size)
+        return -EINVAL;
+
+    mutex_lock(&data->stream_lock);
+    if (ctx->active && size != ctx->ring_size) {
+        ret = -EBUSY;
+    } else {
+        ctx->ring_size = size;
+        WRITE_ONCE(ctx->watermark, buf->watermark);
+    }
+    mutex_unlock(&data->stream_lock);
+    return ret;
 }
 
 // Handle IOCTL commands
 static long ads1115_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
+    struct ads1115_ctx *ctx = file->private_data;
+    struct ads1115_data *ads = ctx->data;
+    struct ads1115_stream_config cfg;
+    struct ads1115_stream_reconfig rc;
+    struct ads1115_buffer_config buf;
+    __u32 version = ADS1115_UAPI_VERSION;
+    u64 start;
     s16 data;
+    int ret;
 
-    if (!ads1115_client) {
-        printk(KERN_ERR DRIVER_NAME ": Client not initialized\n");
+    if (READ_ONCE(ads->removed))
         return -ENODEV;
-    }
 
     switch (cmd) {
         case ADS1115_IOCTL_READ_AIN0:
-            data = ads1115_read_single_channel(ads1115_client, ADS1115_MUX_AIN0_GND);
-            break;
         case ADS1115_IOCTL_READ_AIN1:
-            data = ads1115_read_single_channel(ads1115_client, ADS1115_MUX_AIN1_GND);
-            break;
         case ADS1115_IOCTL_READ_AIN2:
-            data = ads1115_read_single_channel(ads1115_client, ADS1115_MUX_AIN2_GND);
-            break;
         case ADS1115_IOCTL_READ_AIN3:
-            data = ads1115_read_single_channel(ads1115_client, ADS1115_MUX_AIN3_GND);
+            if (!ads->chan[_IOC_NR(cmd)].enabled)
+                return -ENODEV;
+            start = ktime_get_ns();
+            mutex_lock(&ads->lock);
+            if (ads->removed) // Unbound since the check above, the client is gone
+                ret = -ENODEV;
+            else
+                ret = ads1115_read_single_channel(ads, _IOC_NR(cmd), ads->chan[_IOC_NR(cmd)].pga,
+                                                  ads->chan[_IOC_NR(cmd)].data_rate, &data, NULL);
+            mutex_unlock(&ads->lock);
+            ads1115_stats_latency(ads, ktime_get_ns() - start);
             break;
+        case ADS1115_IOCTL_STREAM_START:
+            if (copy_from_user(&cfg, (void __user *)arg, sizeof(cfg)))
+                return -EFAULT;
+            return ads1115_stream_start(ctx, &cfg);
+        case ADS1115_IOCTL_STREAM_STOP:
+            // Without a stream of its own the file stops the autostart stream
+            ads1115_stream_stop(READ_ONCE(ctx->active) ? ctx : &ads->shared);
+            return 0;
+        case ADS1115_IOCTL_STREAM_RECONFIG:
+            if (copy_from_user(&rc, (void __user *)arg, sizeof(rc)))
+                return -EFAULT;
+            ret = ads1115_stream_reconfig(READ_ONCE(ctx->active) ? ctx : &ads->shared, &rc);
+            if (ret < 0)
+                return ret;
+            if (copy_to_user((void __user *)arg, &rc, sizeof(rc)))
+                return -EFAULT;
+            return 0;
+        case ADS1115_IOCTL_SET_BUFFER:
+            if (copy_from_user(&buf, (void __user *)arg, sizeof(buf)))
+                return -EFAULT;
+            return ads1115_set_buffer(ctx, &buf);
+        case ADS1115_IOCTL_GET_VERSION:
+            if (copy_to_user((__u32 __user *)arg, &version, sizeof(version)))
+                return -EFAULT;
+            return 0;
         default:
-            printk(KERN_WARNING DRIVER_NAME ": Invalid IOCTL command: %u\n", cmd);
-            return -EINVAL;
+            dev_dbg(ads->device, "Invalid IOCTL command: %u\n", cmd);
+            return -ENOTTY;
     }
 
-    // Check for I2C errors (heuristic for negative values)
-    if (data < -1000 && (data == -EIO || data == -ETIMEDOUT || data == -ENXIO || data == -EBUSY)) {
-        printk(KERN_ERR DRIVER_NAME ": ADC channel read error: %d\n", data);
-        return data;
-    }
+    // Bus errors were already logged (rate-limited) and counted in stats
+    if (ret < 0)
+        return ret;
 
     if (copy_to_user((s16 __user *)arg, &data, sizeof(data))) {
-        printk(KERN_ERR DRIVER_NAME ": Copy to user error\n");
+        dev_dbg(ads->device, "Copy to user error\n");
         return -EFAULT;
     }
 
     return 0;
 }
 
-static int ads1115_open(struct inode *inodep, struct file *filep)
+// Copy whole sample records from the ring. Works for user buffers and for
+// pipe iterators, so generic_file_splice_read() moves samples into a pipe
+// without a userspace bounce buffer.
+static ssize_t ads1115_read_iter(struct kiocb *iocb, struct iov_iter *to)
 {
-    printk(KERN_INFO DRIVER_NAME ": Device opened\n");
+    struct file *file = iocb->ki_filp;
+    struct ads1115_ctx *ctx = ads1115_file_ctx(file);
+    struct ads1115_data *data = ctx->data;
+    size_t want = iov_iter_count(to) / sizeof(struct ads1115_sample);
+    bool nonblock = (file->f_flags & O_NONBLOCK) || (iocb->ki_flags & IOCB_NOWAIT);
+    unsigned int head, tail, idx, n, i, need, ring_mask;
+    size_t bytes;
+    u64 now;
+    ssize_t copied = 0;
+    ssize_t ret;
+
+    if (!want)
+        return -EINVAL;
+    if (READ_ONCE(data->removed))
+        return -ENODEV;
+
+    if (mutex_lock_interruptible(&ctx->read_lock))
+        return -ERESTARTSYS;
+
+    ret = 0; // Never streamed
+    if (!ctx->ring)
+        goto out;
+
+    // Blocking readers wait for the watermark, or less if they asked for less
+    need = nonblock ? 1 : min_t(size_t, READ_ONCE(ctx->watermark), want);
+    while (!ads1115_ring_ready(ctx, need)) {
+        if (!READ_ONCE(ctx->active)) {
+            if (!ads1115_ring_empty(ctx))
+                break; // Stream stopped, hand out the rest
+            ret = 0; // Stream stopped and drained
+            goto out;
+        }
+        ret = -EAGAIN;
+        if (nonblock)
+            goto out;
+        ret = wait_event_interruptible(ctx->read_wq,
+                                       ads1115_ring_ready(ctx, need) || !READ_ONCE(ctx->active));
+        if (ret)
+            goto out;
+        this_cpu_inc(data->stats->reader_wakeups);
+    }
+
+    ring_mask = ctx->ring_alloc - 1;
+    while (want) {
+        head = smp_load_acquire(&ctx->ring_head);
+        tail = ctx->ring_tail;
+        if (head == tail)
+            break;
+
+        idx = tail & ring_mask;
+        n = min3((size_t)(head - tail), (size_t)(ring_mask + 1 - idx), want);
+        now = ktime_get_ns();
+        for (i = 0; i < n; i++)
+            ads1115_stats_latency(data, now - ctx->ring[idx + i].timestamp_ns);
+        trace_ads1115_sample_dequeue(data->client, n, now - ctx->ring[idx].timestamp_ns);
+        bytes = copy_to_iter(&ctx->ring[idx], n * sizeof(struct ads1115_sample), to);
+        n = bytes / sizeof(struct ads1115_sample);
+        if (!n)
+            break;
+
+        smp_store_release(&ctx->ring_tail, tail + n);
+        copied += n * sizeof(struct ads1115_sample);
+        want -= n;
+        if (bytes % sizeof(struct ads1115_sample))
+            break;
+    }
+    ret = copied ? copied : -EFAULT;
+out:
+    mutex_unlock(&ctx->read_lock);
+    return ret;
+}
+
+static __poll_t ads1115_poll(struct file *file, poll_table *wait)
+{
+    struct ads1115_ctx *ctx = ads1115_file_ctx(file);
+
+    poll_wait(file, &ctx->read_wq, wait);
+
+    if (READ_ONCE(ctx->data->removed))
+        return EPOLLERR | EPOLLHUP;
+    if (!ctx->ring)
+        return EPOLLHUP;
+    if (ads1115_ring_ready(ctx, READ_ONCE(ctx->watermark)))
+        return EPOLLIN | EPOLLRDNORM;
+    if (!READ_ONCE(ctx->active))
+        return ads1115_ring_empty(ctx) ? EPOLLHUP : EPOLLIN | EPOLLRDNORM;
     return 0;
 }
 
+static int ads1115_open(struct inode *inodep, struct file *filep)
+{
+    struct ads1115_data *data = container_of(inodep->i_cdev, struct ads1115_data, cdev);
+    struct ads1115_ctx *ctx;
+
+    ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+    if (!ctx)
+        return -ENOMEM;
+
+    mutex_lock(&data->stream_lock);
+    if (data->removed) {
+        mutex_unlock(&data->stream_lock);
+        kfree(ctx);
+        return -ENODEV;
+    }
+    kref_get(&data->ref);
+    mutex_unlock(&data->stream_lock);
+    ads1115_ctx_init(ctx, data);
+
+    filep->private_data = ctx;
+    dev_dbg(data->device, "Device opened\n");
+    return stream_open(inodep, filep);
+}
+
+// Last reference gone: the chip is unbound and no file is open
+static void ads1115_data_free(struct kref *ref)
+{
+    struct ads1115_data *data = container_of(ref, struct ads1115_data, ref);
+
+    free_percpu(data->stats);
+    kvfree(data->shared.ring);
+    kfree(data);
+}
+
 static int ads1115_release(struct inode *inodep, struct file *filep)
 {
-    printk(KERN_INFO DRIVER_NAME ": Device closed\n");
+    struct ads1115_ctx *ctx = filep->private_data;
+    struct ads1115_data *data = ctx->data;
+
+    ads1115_stream_stop(ctx);
+    if (!READ_ONCE(data->removed)) // The device node is gone otherwise
+        dev_dbg(data->device, "Device closed\n");
+    kvfree(ctx->ring);
+    kfree(ctx);
+    kref_put(&data->ref, ads1115_data_free);
     return 0;
 }
 
@@ -146,52 +1468,695 @@ static int ads1115_release(struct inode *inodep, struct file *filep)
 static struct file_operations fops = {
     .owner = THIS_MODULE,
     .open = ads1115_open,
+    .read_iter = ads1115_read_iter,
+    .splice_read = generic_file_splice_read,
+    .poll = ads1115_poll,
+    .llseek = no_llseek,
     .unlocked_ioctl = ads1115_ioctl,
+    .compat_ioctl = compat_ptr_ioctl, // UAPI structs have one layout for every ABI
     .release = ads1115_release,
 };
 
-// I2C probe function
+// Statistics in sysfs, one value per file under <device>/stats/. Histograms
+// print one count per log2 bucket: <2us, 2-4us, 4-8us, ... up to >=2^19us.
+static ssize_t ads1115_hist_show(const u64 *hist, char *buf)
+{
+    int i, len = 0;
+
+    for (i = 0; i < ADS1115_HIST_BUCKETS; i++)
+        len += sysfs_emit_at(buf, len, "%llu%c", hist[i],
+                             i == ADS1115_HIST_BUCKETS - 1 ? '\n' : ' ');
+    return len;
+}
+
+#define ADS1115_STATS_ATTR(_name, _expr)                                        \
+static ssize_t _name##_show(struct device *dev, struct device_attribute *attr,   \
+                            char *buf)                                          \
+{                                                                               \
+    struct ads1115_stats s;                                                     \
+                                                                                \
+    ads1115_stats_read(dev_get_drvdata(dev), &s);                               \
+    return sysfs_emit(buf, "%llu\n", _expr);                                    \
+}                                                                               \
+static DEVICE_ATTR_RO(_name)
+
+ADS1115_STATS_ATTR(conversions, s.conversions);
+ADS1115_STATS_ATTR(i2c_errors_nak, s.i2c_errors[ADS1115_ERR_NAK]);
+ADS1115_STATS_ATTR(i2c_errors_timeout, s.i2c_errors[ADS1115_ERR_TIMEOUT]);
+ADS1115_STATS_ATTR(i2c_errors_arb_lost, s.i2c_errors[ADS1115_ERR_ARB_LOST]);
+ADS1115_STATS_ATTR(i2c_errors_busy, s.i2c_errors[ADS1115_ERR_BUSY]);
+ADS1115_STATS_ATTR(i2c_errors_other, s.i2c_errors[ADS1115_ERR_OTHER]);
+ADS1115_STATS_ATTR(retries, s.retries);
+ADS1115_STATS_ATTR(recoveries, s.recoveries);
+ADS1115_STATS_ATTR(ring_overruns, s.ring_overruns);
+ADS1115_STATS_ATTR(reader_wakeups, s.reader_wakeups);
+ADS1115_STATS_ATTR(settling_discards, s.settling_discards);
+ADS1115_STATS_ATTR(conversions_skipped, s.conversions_skipped);
+
+static ssize_t recovery_time_last_us_show(struct device *dev, struct device_attribute *attr,
+                                          char *buf)
+{
+    struct ads1115_data *data = dev_get_drvdata(dev);
+
+    return sysfs_emit(buf, "%llu\n", div_u64(READ_ONCE(data->recovery_last_ns), NSEC_PER_USEC));
+}
+static DEVICE_ATTR_RO(recovery_time_last_us);
+
+static ssize_t recovery_time_max_us_show(struct device *dev, struct device_attribute *attr,
+                                         char *buf)
+{
+    struct ads1115_data *data = dev_get_drvdata(dev);
+
+    return sysfs_emit(buf, "%llu\n", div_u64(READ_ONCE(data->recovery_max_ns), NSEC_PER_USEC));
+}
+static DEVICE_ATTR_RO(recovery_time_max_us);
+
+static ssize_t read_latency_hist_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct ads1115_stats s;
+
+    ads1115_stats_read(dev_get_drvdata(dev), &s);
+    return ads1115_hist_show(s.read_latency, buf);
+}
+static DEVICE_ATTR_RO(read_latency_hist);
+
+static ssize_t xfer_time_hist_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct ads1115_stats s;
+
+    ads1115_stats_read(dev_get_drvdata(dev), &s);
+    return ads1115_hist_show(s.xfer_time, buf);
+}
+static DEVICE_ATTR_RO(xfer_time_hist);
+
+static ssize_t ads1115_channel_counts_show(struct ads1115_data *data, const u64 *counts, char *buf)
+{
+    int ch, len = 0;
+
+    for (ch = 0; ch < data->variant->num_channels; ch++)
+        len += sysfs_emit_at(buf, len, "%llu%c", counts[ch],
+                             ch == data->variant->num_channels - 1 ? '\n' : ' ');
+    return len;
+}
+
+// Per-channel range counters, one value per channel of the variant
+#define ADS1115_CHANNEL_STATS_ATTR(_name)                                       \
+static ssize_t _name##_show(struct device *dev, struct device_attribute *attr,  \
+                            char *buf)                                          \
+{                                                                               \
+    struct ads1115_data *data = dev_get_drvdata(dev);                           \
+    struct ads1115_stats s;                                                     \
+                                                                                \
+    ads1115_stats_read(data, &s);                                               \
+    return ads1115_channel_counts_show(data, s._name, buf);                     \
+}                                                                               \
+static DEVICE_ATTR_RO(_name)
+
+ADS1115_CHANNEL_STATS_ATTR(saturated_high);
+ADS1115_CHANNEL_STATS_ATTR(saturated_low);
+ADS1115_CHANNEL_STATS_ATTR(over_range);
+
+// Writing anything clears every counter
+static ssize_t reset_store(struct device *dev, struct device_attribute *attr,
+                           const char *buf, size_t count)
+{
+    struct ads1115_data *data = dev_get_drvdata(dev);
+    int cpu;
+
+    for_each_possible_cpu(cpu)
+        memset(per_cpu_ptr(data->stats, cpu), 0, sizeof(struct ads1115_stats));
+    WRITE_ONCE(data->recovery_last_ns, 0);
+    WRITE_ONCE(data->recovery_max_ns, 0);
+    return count;
+}
+static DEVICE_ATTR_WO(reset);
+
+static struct attribute *ads1115_stats_attrs[] = {
+    &dev_attr_conversions.attr,
+    &dev_attr_i2c_errors_nak.attr,
+    &dev_attr_i2c_errors_timeout.attr,
+    &dev_attr_i2c_errors_arb_lost.attr,
+    &dev_attr_i2c_errors_busy.attr,
+    &dev_attr_i2c_errors_other.attr,
+    &dev_attr_retries.attr,
+    &dev_attr_recoveries.attr,
+    &dev_attr_recovery_time_last_us.attr,
+    &dev_attr_recovery_time_max_us.attr,
+    &dev_attr_ring_overruns.attr,
+    &dev_attr_reader_wakeups.attr,
+    &dev_attr_settling_discards.attr,
+    &dev_attr_conversions_skipped.attr,
+    &dev_attr_saturated_high.attr,
+    &dev_attr_saturated_low.attr,
+    &dev_attr_over_range.attr,
+    &dev_attr_read_latency_hist.attr,
+    &dev_attr_xfer_time_hist.attr,
+    &dev_attr_reset.attr,
+    NULL,
+};
+
+static const struct attribute_group ads1115_stats_group = {
+    .name = "stats",
+    .attrs = ads1115_stats_attrs,
+};
+
+// Acquisition settings under <device>/config/. Per-channel files take one
+// code per channel of the variant, applied together under the conversion lock.
+static ssize_t ads1115_codes_show(struct ads1115_data *data, size_t offset, char *buf)
+{
+    int ch, len = 0;
+
+    for (ch = 0; ch < data->variant->num_channels; ch++)
+        len += sysfs_emit_at(buf, len, "%u%c", *((u8 *)&data->chan[ch] + offset),
+                             ch == data->variant->num_channels - 1 ? '\n' : ' ');
+    return len;
+}
+
+static int ads1115_codes_store(struct ads1115_data *data, size_t offset, unsigned int max,
+                               const char *buf)
+{
+    unsigned int v[ADS1115_NUM_CHANNELS];
+    int ch, n;
+
+    n = sscanf(buf, "%u %u %u %u", &v[0], &v[1], &v[2], &v[3]);
+    if (n != data->variant->num_channels)
+        return -EINVAL;
+    for (ch = 0; ch < n; ch++)
+        if (v[ch] > max)
+            return -EINVAL;
+
+    mutex_lock(&data->lock);
+    for (ch = 0; ch < n; ch++)
+        *((u8 *)&data->chan[ch] + offset) = v[ch];
+    mutex_unlock(&data->lock);
+    return 0;
+}
+
+static ssize_t data_rate_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return ads1115_codes_show(dev_get_drvdata(dev), offsetof(struct ads1115_channel, data_rate), buf);
+}
+
+static ssize_t data_rate_store(struct device *dev, struct device_attribute *attr,
+                               const char *buf, size_t count)
+{
+    int ret = ads1115_codes_store(dev_get_drvdata(dev), offsetof(struct ads1115_channel, data_rate),
+                                  ADS1115_DR_MAX, buf);
+
+    return ret ? ret : count;
+}
+static DEVICE_ATTR_RW(data_rate);
+
+static ssize_t pga_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return ads1115_codes_show(dev_get_drvdata(dev), offsetof(struct ads1115_channel, pga), buf);
+}
+
+static ssize_t pga_store(struct device *dev, struct device_attribute *attr,
+                         const char *buf, size_t count)
+{
+    struct ads1115_data *data = dev_get_drvdata(dev);
+    int ret;
+
+    if (!data->variant->has_pga)
+        return -EOPNOTSUPP;
+    ret = ads1115_codes_store(data, offsetof(struct ads1115_channel, pga), ADS1115_PGA_MAX, buf);
+    return ret ? ret : count;
+}
+static DEVICE_ATTR_RW(pga);
+
+static ssize_t completion_mode_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct ads1115_data *data = dev_get_drvdata(dev);
+    int i, len = 0;
+
+    for (i = 0; i < ARRAY_SIZE(ads1115_completion_names); i++)
+        len += sysfs_emit_at(buf, len, i == data->completion ? "[%s]%c" : "%s%c",
+                             ads1115_completion_names[i],
+                             i == ARRAY_SIZE(ads1115_completion_names) - 1 ? '\n' : ' ');
+    return len;
+}
+
+static ssize_t completion_mode_store(struct device *dev, struct device_attribute *attr,
+                                     const char *buf, size_t count)
+{
+    struct ads1115_data *data = dev_get_drvdata(dev);
+    int mode = sysfs_match_string(ads1115_completion_names, buf);
+
+    if (mode < 0)
+        return mode;
+    if (mode == ADS1115_COMPLETE_IRQ && !data->irq_requested)
+        return -EOPNOTSUPP;
+
+    mutex_lock(&data->lock);
+    if (mode == ADS1115_COMPLETE_IRQ && data->completion != mode)
+        data->chip_ready = false; // Program the RDY thresholds at the next conversion
+    data->completion = mode;
+    mutex_unlock(&data->lock);
+    return count;
+}
+static DEVICE_ATTR_RW(completion_mode);
+
+// Takes effect at the next stream start or reconfig
+static ssize_t stream_strategy_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct ads1115_data *data = dev_get_drvdata(dev);
+    int i, len = 0;
+
+    for (i = 0; i < ARRAY_SIZE(ads1115_strategy_names); i++)
+        len += sysfs_emit_at(buf, len, i == READ_ONCE(data->strategy) ? "[%s]%c" : "%s%c",
+                             ads1115_strategy_names[i],
+                             i == ARRAY_SIZE(ads1115_strategy_names) - 1 ? '\n' : ' ');
+    return len;
+}
+
+static ssize_t stream_strategy_store(struct device *dev, struct device_attribute *attr,
+                                     const char *buf, size_t count)
+{
+    struct ads1115_data *data = dev_get_drvdata(dev);
+    int strategy = sysfs_match_string(ads1115_strategy_names, buf);
+
+    if (strategy < 0)
+        return strategy;
+    WRITE_ONCE(data->strategy, strategy);
+    return count;
+}
+static DEVICE_ATTR_RW(stream_strategy);
+
+static ssize_t ring_size_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct ads1115_data *data = dev_get_drvdata(dev);
+
+    return sysfs_emit(buf, "%u\n", READ_ONCE(data->ring_size));
+}
+
+// ring_size and watermark are the defaults of files opened afterwards; each
+// file can change its own with ADS1115_IOCTL_SET_BUFFER
+static ssize_t ring_size_store(struct device *dev, struct device_attribute *attr,
+                               const char *buf, size_t count)
+{
+    struct ads1115_data *data = dev_get_drvdata(dev);
+    unsigned int size;
+    int ret;
+
+    ret = kstrtouint(buf, 0, &size);
+    if (ret)
+        return ret;
+    if (!is_power_of_2(size) || size < ADS1115_RING_MIN || size > ADS1115_RING_MAX)
+        return -EINVAL;
+
+    mutex_lock(&data->stream_lock);
+    WRITE_ONCE(data->ring_size, size);
+    WRITE_ONCE(data->watermark, min(data->watermark, size));
+    mutex_unlock(&data->stream_lock);
+    return count;
+}
+static DEVICE_ATTR_RW(ring_size);
+
+static ssize_t watermark_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct ads1115_data *data = dev_get_drvdata(dev);
+
+    return sysfs_emit(buf, "%u\n", READ_ONCE(data->watermark));
+}
+
+static ssize_t watermark_store(struct device *dev, struct device_attribute *attr,
+                               const char *buf, size_t count)
+{
+    struct ads1115_data *data = dev_get_drvdata(dev);
+    unsigned int val;
+    int ret;
+
+    ret = kstrtouint(buf, 0, &val);
+    if (ret)
+        return ret;
+
+    mutex_lock(&data->stream_lock); // Keeps ring_size stable
+    if (!val || val > data->ring_size)
+        ret = -EINVAL;
+    else
+        WRITE_ONCE(data->watermark, val);
+    mutex_unlock(&data->stream_lock);
+    return ret ? ret : count;
+}
+static DEVICE_ATTR_RW(watermark);
+
+static struct attribute *ads1115_config_attrs[] = {
+    &dev_attr_data_rate.attr,
+    &dev_attr_pga.attr,
+    &dev_attr_completion_mode.attr,
+    &dev_attr_stream_strategy.attr,
+    &dev_attr_ring_size.attr,
+    &dev_attr_watermark.attr,
+    NULL,
+};
+
+static const struct attribute_group ads1115_config_group = {
+    .name = "config",
+    .attrs = ads1115_config_attrs,
+};
+
+static const struct attribute_group *ads1115_groups[] = {
+    &ads1115_stats_group,
+    &ads1115_config_group,
+    NULL,
+};
+
+// Human-readable summary in debugfs, ads1115/<device>/stats
+static void ads1115_debugfs_hist(struct seq_file *sf, const char *name, const u64 *hist)
+{
+    int i;
+
+    seq_printf(sf, "%s:\n", name);
+    for (i = 0; i < ADS1115_HIST_BUCKETS; i++) {
+        if (!hist[i])
+            continue;
+        if (i == ADS1115_HIST_BUCKETS - 1)
+            seq_printf(sf, "  >=%lu us: %llu\n", 1UL << i, hist[i]);
+        else
+            seq_printf(sf, "  <%lu us: %llu\n", 2UL << i, hist[i]);
+    }
+}
+
+static int ads1115_debugfs_stats_show(struct seq_file *sf, void *unused)
+{
+    struct ads1115_data *data = sf->private;
+    struct ads1115_ctx *ctx;
+    struct ads1115_stats s;
+    int i;
+
+    ads1115_stats_read(data, &s);
+    seq_printf(sf, "variant: %s\n", data->variant->name);
+    seq_printf(sf, "probe_us: %llu\n", div_u64(data->probe_ns, NSEC_PER_USEC));
+    seq_printf(sf, "chip_init_us: %llu\n", div_u64(READ_ONCE(data->chip_init_ns), NSEC_PER_USEC));
+    seq_printf(sf, "conversions: %llu\n", s.conversions);
+    for (i = 0; i < ADS1115_ERR_NUM; i++)
+        seq_printf(sf, "i2c_errors_%s: %llu\n", ads1115_i2c_error_names[i], s.i2c_errors[i]);
+    seq_printf(sf, "retries: %llu\n", s.retries);
+    seq_printf(sf, "recoveries: %llu\n", s.recoveries);
+    seq_printf(sf, "recovery_time_last_us: %llu\n",
+               div_u64(READ_ONCE(data->recovery_last_ns), NSEC_PER_USEC));
+    seq_printf(sf, "recovery_time_max_us: %llu\n",
+               div_u64(READ_ONCE(data->recovery_max_ns), NSEC_PER_USEC));
+    seq_printf(sf, "ring_overruns: %llu\n", s.ring_overruns);
+    seq_printf(sf, "reader_wakeups: %llu\n", s.reader_wakeups);
+    seq_printf(sf, "settling_discards: %llu\n", s.settling_discards);
+    seq_printf(sf, "conversions_skipped: %llu\n", s.conversions_skipped);
+    seq_printf(sf, "xfer_avg_us: %llu\n", div_u64(READ_ONCE(data->xfer_avg_ns), NSEC_PER_USEC));
+    spin_lock(&data->ctx_lock);
+    seq_printf(sf, "contexts: %u\n", data->num_contexts);
+    list_for_each_entry(ctx, &data->contexts, node)
+        seq_printf(sf, "context: mask 0x%x dr %u generation %u fill %u overruns %lu\n",
+                   ctx->cfg.channel_mask, ctx->cfg.data_rate, ctx->gen,
+                   ctx->ring_head - ctx->ring_tail, ctx->ring_overruns);
+    spin_unlock(&data->ctx_lock);
+    seq_printf(sf, "vdd_uv: %u\n", data->vdd_uv);
+    for (i = 0; i < data->variant->num_channels; i++)
+        seq_printf(sf, "channel%d: saturated_high %llu saturated_low %llu over_range %llu\n", i,
+                   s.saturated_high[i], s.saturated_low[i], s.over_range[i]);
+    ads1115_debugfs_hist(sf, "read_latency", s.read_latency);
+    ads1115_debugfs_hist(sf, "xfer_time", s.xfer_time);
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(ads1115_debugfs_stats);
+
+// Read an optional register-code property of a firmware node. Returns 1 and
+// sets *val when present, 0 when absent, and -EINVAL when present but out of
+// range or not supported by the variant.
+static int ads1115_fw_read_code(struct device *dev, struct fwnode_handle *node, const char *prop,
+                                bool supported, u32 max, u32 *val)
+{
+    if (!fwnode_property_present(node, prop))
+        return 0;
+    if (!supported) {
+        dev_err(dev, "%s is not supported by this chip\n", prop);
+        return -EINVAL;
+    }
+    if (fwnode_property_read_u32(node, prop, val) || *val > max) {
+        dev_err(dev, "Invalid %s, must be 0 to %u\n", prop, max);
+        return -EINVAL;
+    }
+    return 1;
+}
+
+// Firmware (device tree or ACPI _DSD) configuration, all optional:
+//   ti,completion-mode = "sleep" | "poll" | "irq"; irq also needs interrupts
+//   ti,datarate = <0..7>;  DR code of the stream started by ti,autostart
+//   ti,autostart;          stream the enabled channels from probe on
+//   vdd-supply = <&reg>;   supply regulator, enables ADS1115_SAMPLE_OVER_RANGE
+//   channel@N {            N = 0..3, the logical channel (READ_AINn, stream mask bit n)
+//       reg = <N>;
+//       ti,mux = <0..7>;       MUX code, default AINn vs GND
+//       ti,gain = <0..5>;      PGA code, default 1 (+/-4.096 V)
+//       ti,datarate = <0..7>;  DR code for single reads, default 4 (128 SPS)
+//   };
+// With channel nodes only the available ones are enabled; without any, all
+// channels of the variant use the defaults. Parts without the multiplexer
+// have one channel, AIN0 - AIN1, and reject ti,mux; parts without a PGA
+// reject ti,gain. A property out of its range fails the probe.
+static int ads1115_parse_fw(struct ads1115_data *data)
+{
+    const struct ads1115_variant *variant = data->variant;
+    struct device *dev = &data->client->dev;
+    struct fwnode_handle *child;
+    struct ads1115_channel *chan;
+    const char *mode;
+    u32 reg, val;
+    int ch, ret;
+
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++) {
+        data->chan[ch].mux = variant->num_channels > 1 ?
+                             ADS1115_MUX_AIN_GND(ch) >> ADS1115_CONFIG_MUX_OFFSET : 0;
+        data->chan[ch].pga = variant->has_pga ? default_pga : ADS1115_PGA_FIXED;
+        data->chan[ch].data_rate = default_data_rate;
+        data->chan[ch].enabled = ch < variant->num_channels && !device_get_child_node_count(dev);
+        data->chan[ch].last_pga = ADS1115_CODE_UNKNOWN;
+    }
+
+    device_for_each_child_node(dev, child) {
+        if (fwnode_property_read_u32(child, "reg", &reg) || reg >= variant->num_channels) {
+            dev_err(dev, "Channel node without a valid reg\n");
+            fwnode_handle_put(child);
+            return -EINVAL;
+        }
+        chan = &data->chan[reg];
+        chan->enabled = true;
+        ret = ads1115_fw_read_code(dev, child, "ti,mux", variant->num_channels > 1,
+                                   ADS1115_MUX_MAX, &val);
+        if (ret > 0)
+            chan->mux = val;
+        if (ret >= 0) {
+            ret = ads1115_fw_read_code(dev, child, "ti,gain", variant->has_pga,
+                                       ADS1115_PGA_MAX, &val);
+            if (ret > 0)
+                chan->pga = val;
+        }
+        if (ret >= 0) {
+            ret = ads1115_fw_read_code(dev, child, "ti,datarate", true, ADS1115_DR_MAX, &val);
+            if (ret > 0)
+                chan->data_rate = val;
+        }
+        if (ret < 0) {
+            fwnode_handle_put(child);
+            return ret;
+        }
+    }
+
+    data->completion = ADS1115_COMPLETE_SLEEP;
+    if (!device_property_read_string(dev, "ti,completion-mode", &mode)) {
+        ret = match_string(ads1115_completion_names, ARRAY_SIZE(ads1115_completion_names), mode);
+        if (ret < 0) {
+            dev_err(dev, "Unknown completion mode %s\n", mode);
+            return ret;
+        }
+        data->completion = ret;
+    }
+    if (data->completion == ADS1115_COMPLETE_IRQ &&
+        (data->client->irq <= 0 || !variant->has_comparator)) {
+        dev_warn(dev, "No ALERT/RDY interrupt for irq completion, sleeping instead\n");
+        data->completion = ADS1115_COMPLETE_SLEEP;
+    }
+
+    data->autostart = device_property_read_bool(dev, "ti,autostart");
+    data->autostart_cfg.channel_mask = ads1115_enabled_mask(data);
+    data->autostart_cfg.data_rate = default_data_rate;
+    ret = ads1115_fw_read_code(dev, dev_fwnode(dev), "ti,datarate", true, ADS1115_DR_MAX, &val);
+    if (ret < 0)
+        return ret;
+    if (ret > 0)
+        data->autostart_cfg.data_rate = val;
+
+    return 0;
+}
+
+// I2C probe function. Probing runs asynchronously and touches no registers:
+// the chip is checked and set up at its first conversion.
 static int ads1115_i2c_probe(struct i2c_client *client, const struct i2c_device_id *id)
 {
-    ads1115_client = client;
+    u64 start = ktime_get_ns();
+    struct ads1115_data *data;
+    struct regulator *vdd;
+    dev_t devt;
+    int ret;
+
+    data = kzalloc(sizeof(*data), GFP_KERNEL);
+    if (!data)
+        return -ENOMEM;
 
-    major_number = register_chrdev(0, DEVICE_NAME, &fops);
-    if (major_number < 0) {
-        printk(KERN_ERR DRIVER_NAME ": Major number registration failed: %d\n", major_number);
-        return major_number;
+    kref_init(&data->ref);
+    data->ring_size = default_ring_size;
+    data->watermark = 1;
+    data->stats = alloc_percpu(struct ads1115_stats);
+    if (!data->stats) {
+        ret = -ENOMEM;
+        goto err_free;
     }
 
-    ads1115_class = class_create(THIS_MODULE, CLASS_NAME);
-    if (IS_ERR(ads1115_class)) {
-        unregister_chrdev(major_number, DEVICE_NAME);
-        printk(KERN_ERR DRIVER_NAME ": Class creation failed\n");
-        return PTR_ERR(ads1115_class);
+    data->client = client;
+    data->last_mux = ADS1115_CODE_UNKNOWN;
+    data->xfer_avg_ns = ADS1115_XFER_INIT_US * NSEC_PER_USEC;
+    data->variant = device_get_match_data(&client->dev);
+    if (!data->variant)
+        data->variant = &ads1115_variants[id ? id->driver_data : ADS1115];
+    mutex_init(&data->lock);
+    mutex_init(&data->stream_lock);
+    spin_lock_init(&data->ctx_lock);
+    INIT_LIST_HEAD(&data->contexts);
+    ads1115_ctx_init(&data->shared, data);
+    INIT_DELAYED_WORK(&data->watchdog, ads1115_watchdog_fn);
+    init_completion(&data->conv_done);
+    i2c_set_clientdata(client, data);
+
+    ret = ads1115_parse_fw(data);
+    if (ret)
+        goto err_free_stats;
+
+    // Optional supply, only used to flag inputs beyond VDD + 0.3 V
+    vdd = devm_regulator_get_optional(&client->dev, "vdd");
+    if (!IS_ERR(vdd)) {
+        ret = regulator_get_voltage(vdd);
+        if (ret > 0)
+            data->vdd_uv = ret;
+    } else if (PTR_ERR(vdd) == -EPROBE_DEFER) {
+        ret = -EPROBE_DEFER;
+        goto err_free_stats;
     }
 
-    ads1115_device = device_create(ads1115_class, NULL, MKDEV(major_number, 0), NULL, DEVICE_NAME);
-    if (IS_ERR(ads1115_device)) {
-        class_destroy(ads1115_class);
-        unregister_chrdev(major_number, DEVICE_NAME);
-        printk(KERN_ERR DRIVER_NAME ": Device creation failed\n");
-        return PTR_ERR(ads1115_device);
+    // Requested whenever wired, so completion_mode can switch to irq later
+    if (client->irq > 0 && data->variant->has_comparator) {
+        ret = request_irq(client->irq, ads1115_irq_handler, 0, dev_name(&client->dev), data);
+        if (!ret) {
+            data->irq_requested = true;
+        } else if (data->completion == ADS1115_COMPLETE_IRQ) {
+            dev_err(&client->dev, "ALERT/RDY interrupt request failed: %d\n", ret);
+            goto err_free_stats;
+        } else {
+            dev_warn(&client->dev, "ALERT/RDY interrupt request failed: %d\n", ret);
+        }
+    }
+
+    data->minor = ida_simple_get(&ads1115_minors, 0, ADS1115_MAX_DEVICES, GFP_KERNEL);
+    if (data->minor < 0) {
+        ret = data->minor;
+        dev_err(&client->dev, "No free minor number: %d\n", ret);
+        goto err_free_irq;
+    }
+    devt = MKDEV(MAJOR(ads1115_devt), data->minor);
+
+    cdev_init(&data->cdev, &fops);
+    data->cdev.owner = THIS_MODULE;
+    ret = cdev_add(&data->cdev, devt, 1);
+    if (ret) {
+        dev_err(&client->dev, "Character device registration failed: %d\n", ret);
+        goto err_free_minor;
     }
 
+    if (data->minor)
+        data->device = device_create_with_groups(ads1115_class, &client->dev, devt, data,
+                                                 ads1115_groups, DEVICE_NAME "-%d", data->minor);
+    else
+        data->device = device_create_with_groups(ads1115_class, &client->dev, devt, data,
+                                                 ads1115_groups, DEVICE_NAME);
+    if (IS_ERR(data->device)) {
+        ret = PTR_ERR(data->device);
+        dev_err(&client->dev, "Device creation failed: %d\n", ret);
+        goto err_del_cdev;
+    }
+
+    // debugfs is best effort, a failure only loses the summary file
+    data->debugfs = debugfs_create_dir(dev_name(data->device), ads1115_debugfs);
+    debugfs_create_file("stats", 0444, data->debugfs, data, &ads1115_debugfs_stats_fops);
+
+    // Autostart only spawns the sampler, its first conversion runs the chip setup
+    if (data->autostart) {
+        ret = ads1115_stream_start(&data->shared, &data->autostart_cfg);
+        if (ret)
+            dev_warn(&client->dev, "Stream autostart failed: %d\n", ret);
+    }
+
+    data->probe_ns = ktime_get_ns() - start;
+    dev_dbg(&client->dev, "%s probed in %llu us\n", data->variant->name,
+            div_u64(data->probe_ns, NSEC_PER_USEC));
+
     return 0;
+
+err_del_cdev:
+    cdev_del(&data->cdev);
+err_free_minor:
+    ida_simple_remove(&ads1115_minors, data->minor);
+err_free_irq:
+    if (data->irq_requested)
+        free_irq(client->irq, data);
+err_free_stats:
+    free_percpu(data->stats);
+err_free:
+    kfree(data);
+    return ret;
 }
 
 // I2C remove function
 static int ads1115_i2c_remove(struct i2c_client *client)
 {
-    device_destroy(ads1115_class, MKDEV(major_number, 0));
-    class_unregister(ads1115_class);
-    class_destroy(ads1115_class);
-    unregister_chrdev(major_number, DEVICE_NAME);
+    struct ads1115_data *data = i2c_get_clientdata(client);
+
+    // Files still open must not reach the client once this returns
+    mutex_lock(&data->stream_lock);
+    mutex_lock(&data->lock);
+    data->removed = true;
+    mutex_unlock(&data->lock);
+    mutex_unlock(&data->stream_lock);
+
+    ads1115_stream_stop_all(data);
+    debugfs_remove_recursive(data->debugfs);
+    device_destroy(ads1115_class, data->cdev.dev);
+    cdev_del(&data->cdev);
+    ida_simple_remove(&ads1115_minors, data->minor);
+    if (data->irq_requested)
+        free_irq(client->irq, data);
+    kref_put(&data->ref, ads1115_data_free);
     return 0;
 }
 
+// I2C device ID table, used when the chip is instantiated by name
+static const struct i2c_device_id ads1115_id[] = {
+    { "ads1013", ADS1013 },
+    { "ads1014", ADS1014 },
+    { "ads1015", ADS1015 },
+    { "ads1113", ADS1113 },
+    { "ads1114", ADS1114 },
+    { "ads1115", ADS1115 },
+    { }
+};
+MODULE_DEVICE_TABLE(i2c, ads1115_id);
+
 // Device Tree match table
 static const struct of_device_id ads1115_of_match[] = {
-    { .compatible = "ti,ads1115" },
+    { .compatible = "ti,ads1013", .data = &ads1115_variants[ADS1013] },
+    { .compatible = "ti,ads1014", .data = &ads1115_variants[ADS1014] },
+    { .compatible = "ti,ads1015", .data = &ads1115_variants[ADS1015] },
+    { .compatible = "ti,ads1113", .data = &ads1115_variants[ADS1113] },
+    { .compatible = "ti,ads1114", .data = &ads1115_variants[ADS1114] },
+    { .compatible = "ti,ads1115", .data = &ads1115_variants[ADS1115] },
     { }
 };
 MODULE_DEVICE_TABLE(of, ads1115_of_match);
@@ -202,19 +2167,54 @@ static struct i2c_driver ads1115_driver = {
         .name   = DRIVER_NAME,
         .owner  = THIS_MODULE,
         .of_match_table = of_match_ptr(ads1115_of_match),
+        .probe_type = PROBE_PREFER_ASYNCHRONOUS,
     },
     .probe      = ads1115_i2c_probe,
     .remove     = ads1115_i2c_remove,
+    .id_table   = ads1115_id,
 };
 
 // Module initialization
 static int __init ads1115_init(void) {
-    return i2c_add_driver(&ads1115_driver);
+    int ret;
+
+    if (default_data_rate > ADS1115_DR_MAX || default_pga > ADS1115_PGA_MAX ||
+        !is_power_of_2(default_ring_size) || default_ring_size < ADS1115_RING_MIN ||
+        default_ring_size > ADS1115_RING_MAX) {
+        printk(KERN_ERR DRIVER_NAME ": Invalid default_data_rate, default_pga or default_ring_size\n");
+        return -EINVAL;
+    }
+
+    ret = alloc_chrdev_region(&ads1115_devt, 0, ADS1115_MAX_DEVICES, DEVICE_NAME);
+    if (ret < 0) {
+        printk(KERN_ERR DRIVER_NAME ": Device number allocation failed: %d\n", ret);
+        return ret;
+    }
+
+    ads1115_class = class_create(THIS_MODULE, CLASS_NAME);
+    if (IS_ERR(ads1115_class)) {
+        unregister_chrdev_region(ads1115_devt, ADS1115_MAX_DEVICES);
+        printk(KERN_ERR DRIVER_NAME ": Class creation failed\n");
+        return PTR_ERR(ads1115_class);
+    }
+
+    ads1115_debugfs = debugfs_create_dir(DEVICE_NAME, NULL);
+
+    ret = i2c_add_driver(&ads1115_driver);
+    if (ret) {
+        debugfs_remove_recursive(ads1115_debugfs);
+        class_destroy(ads1115_class);
+        unregister_chrdev_region(ads1115_devt, ADS1115_MAX_DEVICES);
+    }
+    return ret;
 }
 
 // Module cleanup
 static void __exit ads1115_exit(void) {
     i2c_del_driver(&ads1115_driver);
+    debugfs_remove_recursive(ads1115_debugfs);
+    class_destroy(ads1115_class);
+    unregister_chrdev_region(ads1115_devt, ADS1115_MAX_DEVICES);
 }
 
 module_init(ads1115_init);
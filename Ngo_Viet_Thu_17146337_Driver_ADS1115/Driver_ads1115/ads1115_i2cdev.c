@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "ads1115_lib_internal.h"
+#include "ads1115_model.h"
+
+// Userspace backend for hosts without the kernel module. Each conversion is
+// two combined transfers: the config write, then the pointer write and result
+// read joined by a repeated start. Transfers go to /dev/i2c-N with I2C_RDWR,
+// or straight into a software model of the chip. With a virtual clock the
+// model also charges bus time for each message at 400 kHz, and the time a
+// stuck bus is held when the model injects a timeout or busy fault.
+// Transient bus errors are retried with the same policy as the driver.
+
+#define MODEL_BUS_BIT_NS 2500 // One SCL period at 400 kHz
+
+static int i2cdev_xfer(struct ads1115_dev *dev, struct i2c_msg *msgs, unsigned int nmsgs) {
+    struct i2c_rdwr_ioctl_data xfer = { .msgs = msgs, .nmsgs = nmsgs };
+
+    dev->stats.syscalls++;
+    dev->stats.transactions++;
+    if (ioctl(dev->fd, I2C_RDWR, &xfer) < 0)
+        return -errno;
+    return 0;
+}
+
+static int model_xfer(struct ads1115_dev *dev, struct i2c_msg *msgs, unsigned int nmsgs) {
+    uint64_t now;
+    unsigned int i;
+    int ret;
+
+    dev->stats.syscalls++; // One I2C_RDWR on real hardware
+    dev->stats.transactions++;
+    dev->model->stats.transactions++;
+
+    ret = ads1115_model_fault(dev->model);
+    if (ret == -ETIMEDOUT || ret == -EBUSY)
+        ads1115_dev_sleep_us(dev, dev->model->faults.stuck_us);
+    if (ret < 0)
+        return ret;
+
+    for (i = 0; i < nmsgs; i++) {
+        if (dev->vclock) // Start, address byte, data bytes (9 clocks each), stop
+            dev->vclock->now_ns += (2 + 9 * (1 + msgs[i].len)) * MODEL_BUS_BIT_NS;
+        now = ads1115_dev_now_ns(dev);
+        if (msgs[i].flags & I2C_M_RD)
+            ret = ads1115_model_read(dev->model, now, msgs[i].buf, msgs[i].len);
+        else
+            ret = ads1115_model_write(dev->model, now, msgs[i].buf, msgs[i].len);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int xfer_retryable(int ret) {
+    return ret == -ENXIO || ret == -EREMOTEIO || ret == -ETIMEDOUT ||
+           ret == -EAGAIN || ret == -EBUSY;
+}
+
+// dev->xfer with retries and a doubling backoff, as in the driver
+static int xfer_retry(struct ads1115_dev *dev, struct i2c_msg *msgs, unsigned int nmsgs) {
+    unsigned int attempt, backoff = dev->retry_backoff_us;
+    int ret;
+
+    for (attempt = 0; ; attempt++) {
+        ret = dev->xfer(dev, msgs, nmsgs);
+        if (ret >= 0 || attempt >= dev->retries || !xfer_retryable(ret))
+            return ret;
+
+        dev->stats.retries++;
+        if (backoff)
+            ads1115_dev_sleep_us(dev, backoff);
+        backoff = backoff * 2 < ADS1115_RETRY_BACKOFF_MAX_US ? backoff * 2 : ADS1115_RETRY_BACKOFF_MAX_US;
+    }
+}
+
+static int i2cdev_write_config(struct ads1115_dev *dev, uint16_t config) {
+    uint8_t buf[3] = { ADS1115_REG_POINTER_CONFIG, config >> 8, config & 0xff };
+    struct i2c_msg msg = { .addr = dev->addr, .flags = 0, .len = sizeof(buf), .buf = buf };
+
+    return xfer_retry(dev, &msg, 1);
+}
+
+static int i2cdev_read_conversion(struct ads1115_dev *dev, int16_t *value) {
+    uint8_t reg = ADS1115_REG_POINTER_CONVERSION;
+    uint8_t buf[2];
+    struct i2c_msg msgs[2] = {
+        { .addr = dev->addr, .flags = 0, .len = 1, .buf = &reg },
+        { .addr = dev->addr, .flags = I2C_M_RD, .len = sizeof(buf), .buf = buf },
+    };
+    int ret;
+
+    ret = xfer_retry(dev, msgs, 2);
+    if (ret < 0)
+        return ret;
+    *value = (int16_t)((buf[0] << 8) | buf[1]); // Registers are big-endian
+    return 0;
+}
+
+static int i2cdev_read_channel(struct ads1115_dev *dev, unsigned int channel,
+                               unsigned int data_rate, int16_t *value) {
+    uint16_t config;
+    int ret;
+
+    if (data_rate == ADS1115_DR_CHANNEL)
+        data_rate = ADS1115_DR_128SPS;
+    config = ADS1115_CONFIG_BASE | ADS1115_MUX_AIN_GND(channel) |
+             ADS1115_CONFIG_PGA(dev->pga[channel]) | (data_rate << ADS1115_CONFIG_DR_OFFSET);
+    ret = i2cdev_write_config(dev, config);
+    if (ret < 0)
+        return ret;
+
+    ads1115_dev_sleep_us(dev, ads1115_conv_time_us(data_rate)); // Wait for ADC conversion
+
+    return i2cdev_read_conversion(dev, value);
+}
+
+static void i2cdev_close(struct ads1115_dev *dev) {
+    if (dev->fd >= 0)
+        close(dev->fd);
+}
+
+static const struct ads1115_backend_ops i2cdev_ops = {
+    .name = "i2cdev",
+    .read_channel = i2cdev_read_channel,
+    .stream_start = ads1115_soft_stream_start,
+    .stream_read = ads1115_soft_stream_read,
+    .stream_stop = ads1115_soft_stream_stop,
+    .stream_reconfig = ads1115_soft_stream_reconfig,
+    .close = i2cdev_close,
+};
+
+static const struct ads1115_backend_ops model_ops = {
+    .name = "model",
+    .read_channel = i2cdev_read_channel,
+    .stream_start = ads1115_soft_stream_start,
+    .stream_read = ads1115_soft_stream_read,
+    .stream_stop = ads1115_soft_stream_stop,
+    .stream_reconfig = ads1115_soft_stream_reconfig,
+    .close = i2cdev_close,
+};
+
+struct ads1115_dev *ads1115_open_i2cdev(int bus, int addr) {
+    struct ads1115_dev *dev;
+    char path[32];
+    unsigned long funcs;
+    int err;
+
+    if (addr < 0x48 || addr > 0x4b) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    dev = ads1115_dev_alloc(&i2cdev_ops);
+    if (!dev)
+        return NULL;
+
+    snprintf(path, sizeof(path), "/dev/i2c-%d", bus);
+    dev->fd = open(path, O_RDWR);
+    if (dev->fd < 0)
+        goto fail;
+
+    if (ioctl(dev->fd, I2C_FUNCS, &funcs) < 0)
+        goto fail_close;
+    if (!(funcs & I2C_FUNC_I2C)) {
+        errno = EOPNOTSUPP; // Adapter cannot do combined transfers
+        goto fail_close;
+    }
+
+    dev->addr = addr;
+    dev->xfer = i2cdev_xfer;
+    return dev;
+
+fail_close:
+    err = errno;
+    close(dev->fd);
+    errno = err;
+fail:
+    free(dev);
+    return NULL;
+}
+
+struct ads1115_dev *ads1115_open_model(struct ads1115_model *model, struct ads1115_vclock *vclock) {
+    struct ads1115_dev *dev = ads1115_dev_alloc(&model_ops);
+
+    if (!dev)
+        return NULL;
+    dev->addr = 0x48;
+    dev->model = model;
+    dev->vdd_uv = model->vdd_uv;
+    dev->vclock = vclock;
+    dev->xfer = model_xfer;
+    return dev;
+}
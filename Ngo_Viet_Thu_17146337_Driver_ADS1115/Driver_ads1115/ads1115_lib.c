@@ -0,0 +1,357 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/ioctl.h>
+
+#include "ads1115_lib_internal.h"
+
+// Samples per second for each DR code
+static const unsigned int ads1115_data_rate_sps[] = { 8, 16, 32, 64, 128, 250, 475, 860 };
+
+// Full-scale range in microvolts for each PGA code
+static const uint32_t ads1115_fsr_uv[] = { 6144000, 4096000, 2048000, 1024000, 512000, 256000 };
+
+unsigned int ads1115_conv_time_us(unsigned int data_rate) {
+    // Nominal period plus 10% oscillator tolerance, as in the driver
+    return (1000000u * 11 + ads1115_data_rate_sps[data_rate] * 10 - 1) /
+           (ads1115_data_rate_sps[data_rate] * 10) + 50;
+}
+
+uint64_t ads1115_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void ads1115_sleep_us(unsigned int us) {
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000L };
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR)
+        ;
+}
+
+uint64_t ads1115_dev_now_ns(const struct ads1115_dev *dev) {
+    return dev->vclock ? dev->vclock->now_ns : ads1115_now_ns();
+}
+
+void ads1115_dev_sleep_us(struct ads1115_dev *dev, unsigned int us) {
+    if (dev->vclock)
+        dev->vclock->now_ns += us * 1000ull;
+    else
+        ads1115_sleep_us(us);
+}
+
+struct ads1115_dev *ads1115_dev_alloc(const struct ads1115_backend_ops *ops) {
+    struct ads1115_dev *dev = calloc(1, sizeof(*dev));
+
+    if (dev) {
+        dev->ops = ops;
+        dev->fd = -1;
+        dev->retries = ADS1115_RETRIES_DEFAULT;
+        dev->retry_backoff_us = ADS1115_RETRY_BACKOFF_US_DEFAULT;
+        dev->last_channel = -1;
+        memset(dev->pga, ADS1115_PGA_DEFAULT, sizeof(dev->pga));
+    }
+    return dev;
+}
+
+int ads1115_soft_stream_start(struct ads1115_dev *dev, const struct ads1115_stream_config *cfg) {
+    dev->cfg = *cfg;
+    dev->next_channel = 0;
+    dev->seq = 0;
+    dev->generation = 0;
+    dev->staged_pending = 0;
+    dev->staged_gen = 0;
+    dev->gain_changed = 0;
+    dev->streaming = 1;
+    return 0;
+}
+
+// Take the staged config between conversions, as the driver's sampler does
+static void soft_stream_apply_staged(struct ads1115_dev *dev) {
+    unsigned int ch;
+
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++)
+        if (dev->staged.pga[ch] != ADS1115_PGA_KEEP && dev->staged.pga[ch] != dev->pga[ch]) {
+            dev->pga[ch] = dev->staged.pga[ch];
+            dev->gain_changed |= 1u << ch;
+        }
+    dev->cfg.channel_mask = dev->staged.channel_mask;
+    dev->cfg.data_rate = dev->staged.data_rate;
+    dev->generation = dev->staged.generation;
+    dev->staged_pending = 0;
+}
+
+ssize_t ads1115_soft_stream_read(struct ads1115_dev *dev, struct ads1115_sample *buf, size_t count) {
+    unsigned int ch;
+    size_t n = 0, pass;
+    int16_t value;
+    int ret;
+
+    if (!dev->streaming)
+        return 0;
+
+    pass = __builtin_popcount(dev->cfg.channel_mask);
+    while (n < count && n < pass) {
+        if (dev->staged_pending)
+            soft_stream_apply_staged(dev);
+        ch = dev->next_channel;
+        dev->next_channel = (ch + 1) % ADS1115_NUM_CHANNELS;
+        if (!(dev->cfg.channel_mask & (1u << ch)))
+            continue;
+
+        ret = dev->ops->read_channel(dev, ch, dev->cfg.data_rate, &value);
+        if (ret < 0)
+            return n ? (ssize_t)n : ret;
+
+        buf[n].timestamp_ns = ads1115_dev_now_ns(dev);
+        buf[n].value = value;
+        buf[n].channel = ch;
+        buf[n].flags = 0;
+        if (value == INT16_MAX)
+            buf[n].flags |= ADS1115_SAMPLE_SAT_HIGH;
+        else if (value == INT16_MIN)
+            buf[n].flags |= ADS1115_SAMPLE_SAT_LOW;
+        // Same threshold as the driver: at or beyond VDD + 0.3 V
+        if (dev->vdd_uv && ((int64_t)abs(value) * ads1115_fsr_uv[dev->pga[ch]] >> 15) >=
+                           (int64_t)dev->vdd_uv + ADS1115_OVER_RANGE_MARGIN_UV)
+            buf[n].flags |= ADS1115_SAMPLE_OVER_RANGE;
+        if (dev->gain_changed & (1u << ch))
+            buf[n].flags |= ADS1115_SAMPLE_GAIN_CHANGED;
+        if (dev->last_channel >= 0 && dev->last_channel != (int)ch)
+            buf[n].flags |= ADS1115_SAMPLE_MUX_SWITCH;
+        dev->gain_changed &= ~(1u << ch);
+        dev->last_channel = ch;
+        buf[n].seq = dev->seq++;
+        buf[n].generation = dev->generation;
+        n++;
+    }
+    return n;
+}
+
+int ads1115_soft_stream_stop(struct ads1115_dev *dev) {
+    dev->streaming = 0;
+    return 0;
+}
+
+int ads1115_soft_stream_reconfig(struct ads1115_dev *dev, const struct ads1115_stream_reconfig *rc) {
+    dev->staged = *rc;
+    dev->staged.generation = ++dev->staged_gen;
+    dev->staged_pending = 1;
+    return dev->staged.generation;
+}
+
+// Kernel driver backend
+
+static int chrdev_read_channel(struct ads1115_dev *dev, unsigned int channel,
+                               unsigned int data_rate, int16_t *value) {
+    int16_t data;
+
+    // The driver converts at the channel's configured DR (config/data_rate)
+    // and the per-channel ioctls cannot override it
+    if (data_rate != ADS1115_DR_CHANNEL)
+        return -EOPNOTSUPP;
+    dev->stats.syscalls++;
+    if (ioctl(dev->fd, ADS1115_IOCTL_READ_AIN(channel), &data) < 0)
+        return -errno;
+    *value = data;
+    return 0;
+}
+
+static int chrdev_stream_start(struct ads1115_dev *dev, const struct ads1115_stream_config *cfg) {
+    dev->stats.syscalls++;
+    if (ioctl(dev->fd, ADS1115_IOCTL_STREAM_START, cfg) < 0)
+        return -errno;
+    dev->cfg = *cfg;
+    dev->streaming = 1;
+    return 0;
+}
+
+static ssize_t chrdev_stream_read(struct ads1115_dev *dev, struct ads1115_sample *buf, size_t count) {
+    ssize_t n = read(dev->fd, buf, count * sizeof(*buf));
+
+    dev->stats.syscalls++;
+    if (n < 0)
+        return -errno;
+    return n / sizeof(*buf);
+}
+
+static int chrdev_stream_stop(struct ads1115_dev *dev) {
+    dev->streaming = 0;
+    dev->stats.syscalls++;
+    if (ioctl(dev->fd, ADS1115_IOCTL_STREAM_STOP) < 0)
+        return -errno;
+    return 0;
+}
+
+static int chrdev_stream_reconfig(struct ads1115_dev *dev, const struct ads1115_stream_reconfig *rc) {
+    struct ads1115_stream_reconfig arg = *rc;
+
+    dev->stats.syscalls++;
+    if (ioctl(dev->fd, ADS1115_IOCTL_STREAM_RECONFIG, &arg) < 0)
+        return -errno;
+    dev->cfg.channel_mask = arg.channel_mask;
+    dev->cfg.data_rate = arg.data_rate;
+    return arg.generation;
+}
+
+static void chrdev_close(struct ads1115_dev *dev) {
+    close(dev->fd);
+}
+
+static const struct ads1115_backend_ops chrdev_ops = {
+    .name = "chrdev",
+    .read_channel = chrdev_read_channel,
+    .stream_start = chrdev_stream_start,
+    .stream_read = chrdev_stream_read,
+    .stream_stop = chrdev_stream_stop,
+    .stream_reconfig = chrdev_stream_reconfig,
+    .close = chrdev_close,
+};
+
+struct ads1115_dev *ads1115_open_chrdev(const char *path) {
+    struct ads1115_dev *dev = ads1115_dev_alloc(&chrdev_ops);
+    __u32 version;
+    int err;
+
+    if (!dev)
+        return NULL;
+    dev->fd = open(path, O_RDONLY);
+    if (dev->fd < 0) {
+        free(dev);
+        return NULL;
+    }
+    // Drivers older than the version ioctl reject it as an unknown command
+    // (EINVAL before the driver returned ENOTTY for those) and use the
+    // version 1 layouts. Any other error is real.
+    if (ioctl(dev->fd, ADS1115_IOCTL_GET_VERSION, &version) < 0) {
+        if (errno != ENOTTY && errno != EINVAL)
+            goto fail;
+        version = 1;
+    }
+    if (version != ADS1115_UAPI_VERSION) {
+        errno = EPROTO;
+        goto fail;
+    }
+    return dev;
+
+fail:
+    err = errno;
+    close(dev->fd);
+    free(dev);
+    errno = err;
+    return NULL;
+}
+
+// Public API
+
+void ads1115_close(struct ads1115_dev *dev) {
+    if (!dev)
+        return;
+    if (dev->streaming)
+        dev->ops->stream_stop(dev);
+    dev->ops->close(dev);
+    free(dev);
+}
+
+const char *ads1115_backend_name(const struct ads1115_dev *dev) {
+    return dev->ops->name;
+}
+
+void ads1115_get_stats(const struct ads1115_dev *dev, struct ads1115_dev_stats *stats) {
+    *stats = dev->stats;
+}
+
+int ads1115_set_retry(struct ads1115_dev *dev, unsigned int retries, unsigned int backoff_us) {
+    if (!dev->xfer)
+        return -EOPNOTSUPP; // Kernel driver: module parameters
+    dev->retries = retries;
+    dev->retry_backoff_us = backoff_us;
+    return 0;
+}
+
+int ads1115_set_vdd(struct ads1115_dev *dev, uint32_t vdd_uv) {
+    if (!dev->xfer)
+        return -EOPNOTSUPP; // Kernel driver: vdd regulator
+    dev->vdd_uv = vdd_uv;
+    return 0;
+}
+
+int ads1115_read_channel(struct ads1115_dev *dev, unsigned int channel, int16_t *value) {
+    if (channel >= ADS1115_NUM_CHANNELS)
+        return -EINVAL;
+    return dev->ops->read_channel(dev, channel, ADS1115_DR_CHANNEL, value);
+}
+
+int ads1115_scan(struct ads1115_dev *dev, uint32_t channel_mask, int16_t *values) {
+    unsigned int ch;
+    int ret;
+
+    if (!channel_mask || channel_mask >> ADS1115_NUM_CHANNELS)
+        return -EINVAL;
+
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++) {
+        if (!(channel_mask & (1u << ch)))
+            continue;
+        ret = dev->ops->read_channel(dev, ch, ADS1115_DR_CHANNEL, &values[ch]);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+int ads1115_stream_start(struct ads1115_dev *dev, const struct ads1115_stream_config *cfg) {
+    if (!cfg->channel_mask || cfg->channel_mask >> ADS1115_NUM_CHANNELS ||
+        cfg->data_rate > ADS1115_DR_MAX)
+        return -EINVAL;
+    if (dev->streaming)
+        return -EBUSY;
+    return dev->ops->stream_start(dev, cfg);
+}
+
+ssize_t ads1115_stream_read(struct ads1115_dev *dev, struct ads1115_sample *buf, size_t count) {
+    if (!count)
+        return -EINVAL;
+    return dev->ops->stream_read(dev, buf, count);
+}
+
+int ads1115_stream_reconfig(struct ads1115_dev *dev, struct ads1115_stream_reconfig *rc) {
+    unsigned int ch;
+    int ret;
+
+    if (!rc->channel_mask || rc->channel_mask >> ADS1115_NUM_CHANNELS ||
+        rc->data_rate > ADS1115_DR_MAX || rc->reserved)
+        return -EINVAL;
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++)
+        if (rc->pga[ch] != ADS1115_PGA_KEEP && rc->pga[ch] > ADS1115_PGA_MAX)
+            return -EINVAL;
+    if (!dev->streaming)
+        return -EINVAL; // No stream to reconfigure
+
+    ret = dev->ops->stream_reconfig(dev, rc);
+    if (ret < 0)
+        return ret;
+    rc->generation = ret;
+    return 0;
+}
+
+int ads1115_set_buffer(struct ads1115_dev *dev, const struct ads1115_buffer_config *buf) {
+    if (dev->ops != &chrdev_ops)
+        return -EOPNOTSUPP; // Userspace backends convert on demand, no ring
+    dev->stats.syscalls++;
+    if (ioctl(dev->fd, ADS1115_IOCTL_SET_BUFFER, buf) < 0)
+        return -errno;
+    return 0;
+}
+
+int ads1115_poll_fd(const struct ads1115_dev *dev) {
+    return dev->ops == &chrdev_ops ? dev->fd : -1;
+}
+
+int ads1115_stream_stop(struct ads1115_dev *dev) {
+    if (!dev->streaming)
+        return 0;
+    return dev->ops->stream_stop(dev);
+}
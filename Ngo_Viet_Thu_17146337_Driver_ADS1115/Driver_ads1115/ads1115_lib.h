@@ -0,0 +1,107 @@
+#ifndef ADS1115_LIB_H
+#define ADS1115_LIB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "ads1115_uapi.h"
+
+// Client library for the ADS1115. The same calls work against the kernel
+// driver (/dev/ads1115) or directly against the chip through /dev/i2c-N on
+// hosts that cannot load the module. Functions return 0 or a count on
+// success and -errno on failure.
+
+#define ADS1115_NUM_CHANNELS 4    // Single-ended inputs AIN0..AIN3
+#define ADS1115_DR_128SPS    0x04 // Default DR code (128 samples/second)
+#define ADS1115_DR_MAX       0x07 // Highest DR code (860 samples/second)
+#define ADS1115_PGA_DEFAULT  0x01 // Default PGA code (+/-4.096V)
+#define ADS1115_PGA_MAX      0x05 // Highest PGA code (+/-0.256V)
+
+struct ads1115_dev;
+struct ads1115_model;
+
+// Simulated time for software chips: sleeps advance the clock instead of
+// blocking, so runs are fast and fully deterministic. Devices sharing one
+// clock see a single timeline.
+struct ads1115_vclock {
+    uint64_t now_ns;
+};
+
+// Work done by the library on behalf of a device
+struct ads1115_dev_stats {
+    uint64_t syscalls;     // ioctl()/read() calls issued (emulated for the model backend)
+    uint64_t transactions; // Combined I2C transfers (userspace backends only)
+    uint64_t retries;      // Transfers repeated after a bus error (userspace backends only)
+};
+
+// Open the kernel driver character device, e.g. "/dev/ads1115". Fails with
+// EPROTO if the driver reports a different ADS1115_UAPI_VERSION.
+struct ads1115_dev *ads1115_open_chrdev(const char *path);
+
+// Open a chip on /dev/i2c-<bus> at a 7-bit address (0x48..0x4B)
+struct ads1115_dev *ads1115_open_i2cdev(int bus, int addr);
+
+// Run the i2c-dev backend against a software chip (see ads1115_model.h).
+// The model is owned by the caller and must outlive the device. With a NULL
+// vclock the model runs in real time.
+struct ads1115_dev *ads1115_open_model(struct ads1115_model *model, struct ads1115_vclock *vclock);
+
+void ads1115_close(struct ads1115_dev *dev);
+
+// Backend name ("chrdev", "i2cdev", "model") for reports
+const char *ads1115_backend_name(const struct ads1115_dev *dev);
+
+// Single-shot conversion of AIN<channel> at the channel's data rate: the
+// driver's config/data_rate on chrdev, 128 samples/second on the others
+int ads1115_read_channel(struct ads1115_dev *dev, unsigned int channel, int16_t *value);
+
+// Convert every channel in channel_mask in ascending order, values[ch] is filled
+int ads1115_scan(struct ads1115_dev *dev, uint32_t channel_mask, int16_t *values);
+
+// Continuous acquisition of the configured channels
+int ads1115_stream_start(struct ads1115_dev *dev, const struct ads1115_stream_config *cfg);
+ssize_t ads1115_stream_read(struct ads1115_dev *dev, struct ads1115_sample *buf, size_t count);
+int ads1115_stream_stop(struct ads1115_dev *dev);
+
+// Switch a running stream to a new channel set, data rate and gains without
+// stopping it. The switch happens at the next conversion boundary; samples
+// taken with the new config carry rc->generation, a 16-bit tag that wraps
+// after 65535 reconfigs (see ads1115_stream_reconfig). A second call before
+// the switch replaces the first.
+int ads1115_stream_reconfig(struct ads1115_dev *dev, struct ads1115_stream_reconfig *rc);
+
+// Ring size and watermark of this device handle's stream (chrdev only, the
+// ring size only while stopped). Every handle on the driver streams its own
+// channels and rate; the driver merges them into one conversion schedule.
+int ads1115_set_buffer(struct ads1115_dev *dev, const struct ads1115_buffer_config *buf);
+
+// File descriptor that poll() reports readable when stream samples are
+// waiting (chrdev only). Other backends convert inside ads1115_stream_read()
+// and return -1.
+int ads1115_poll_fd(const struct ads1115_dev *dev);
+
+// Conversion time in microseconds for a DR code, as used by the driver
+unsigned int ads1115_conv_time_us(unsigned int data_rate);
+
+// CLOCK_MONOTONIC in nanoseconds, the clock used for sample timestamps
+uint64_t ads1115_now_ns(void);
+
+// Time on the device's clock: virtual time for simulated chips, else CLOCK_MONOTONIC
+uint64_t ads1115_dev_now_ns(const struct ads1115_dev *dev);
+
+void ads1115_get_stats(const struct ads1115_dev *dev, struct ads1115_dev_stats *stats);
+
+// Retry policy for transient bus errors (NAK, timeout, busy, lost arbitration):
+// up to retries repeats, the first after backoff_us, doubling after that.
+// Defaults match the driver (2 retries, 200 us). The chrdev backend returns
+// -EOPNOTSUPP, the driver's policy is set through its module parameters.
+int ads1115_set_retry(struct ads1115_dev *dev, unsigned int retries, unsigned int backoff_us);
+
+// Supply voltage used to set ADS1115_SAMPLE_OVER_RANGE on streamed samples,
+// 0 to leave the flag unset. The model backend starts with the model's VDD,
+// i2c-dev with 0. The chrdev backend returns -EOPNOTSUPP, the driver reads
+// its vdd regulator.
+int ads1115_set_vdd(struct ads1115_dev *dev, uint32_t vdd_uv);
+
+#endif
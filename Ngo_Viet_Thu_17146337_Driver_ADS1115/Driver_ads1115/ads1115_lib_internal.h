@@ -0,0 +1,82 @@
+#ifndef ADS1115_LIB_INTERNAL_H
+#define ADS1115_LIB_INTERNAL_H
+
+#include <linux/i2c.h>
+
+#include "ads1115_lib.h"
+
+// ADS1115 register addresses
+#define ADS1115_REG_POINTER_CONVERSION  0x00
+#define ADS1115_REG_POINTER_CONFIG      0x01
+
+// Config register bits, same values the kernel driver writes
+#define ADS1115_CONFIG_OS_SINGLE    0x8000
+#define ADS1115_CONFIG_MUX_OFFSET   12
+#define ADS1115_CONFIG_PGA_OFFSET   9
+#define ADS1115_CONFIG_MODE_SINGLE  0x0100
+#define ADS1115_CONFIG_DR_OFFSET    5
+#define ADS1115_MUX_AIN_GND(ch)     ((0x04 + (ch)) << ADS1115_CONFIG_MUX_OFFSET)
+#define ADS1115_CONFIG_PGA(pga)     ((pga) << ADS1115_CONFIG_PGA_OFFSET)
+#define ADS1115_CONFIG_BASE (ADS1115_CONFIG_OS_SINGLE | \
+                             ADS1115_CONFIG_MODE_SINGLE | \
+                             0x0003) // Disable comparator
+
+#define ADS1115_RETRIES_DEFAULT          2     // Same policy as the driver
+#define ADS1115_RETRY_BACKOFF_US_DEFAULT 200
+#define ADS1115_RETRY_BACKOFF_MAX_US     10000
+
+// read_channel data_rate for the channel's own rate: the driver's configured
+// DR on chrdev, ADS1115_DR_128SPS on the userspace backends
+#define ADS1115_DR_CHANNEL 0xff
+
+// Per-backend operations behind the public API
+struct ads1115_backend_ops {
+    const char *name;
+    int (*read_channel)(struct ads1115_dev *dev, unsigned int channel,
+                        unsigned int data_rate, int16_t *value);
+    int (*stream_start)(struct ads1115_dev *dev, const struct ads1115_stream_config *cfg);
+    ssize_t (*stream_read)(struct ads1115_dev *dev, struct ads1115_sample *buf, size_t count);
+    int (*stream_stop)(struct ads1115_dev *dev);
+    int (*stream_reconfig)(struct ads1115_dev *dev, const struct ads1115_stream_reconfig *rc);
+    void (*close)(struct ads1115_dev *dev);
+};
+
+struct ads1115_dev {
+    const struct ads1115_backend_ops *ops;
+    int fd;                            // chrdev or i2c-dev file descriptor
+    int addr;                          // I2C address (i2c-dev and model backends)
+    struct ads1115_model *model;       // Software chip (model backend)
+    struct ads1115_vclock *vclock;     // Simulated time, NULL for real time
+    struct ads1115_dev_stats stats;
+    // Combined I2C transfer: /dev/i2c-N or the software model
+    int (*xfer)(struct ads1115_dev *dev, struct i2c_msg *msgs, unsigned int nmsgs);
+    unsigned int retries;              // Retry policy for transient bus errors
+    unsigned int retry_backoff_us;
+    uint8_t pga[ADS1115_NUM_CHANNELS]; // PGA code per channel (userspace backends)
+    uint32_t vdd_uv;                   // Supply voltage for over-range flags, 0 when unknown
+    int streaming;                     // Stream started
+    struct ads1115_stream_config cfg;  // Active stream config
+    unsigned int next_channel;         // Round-robin position (userspace streaming)
+    uint16_t seq;                      // Next sample sequence number
+    uint16_t generation;               // Generation of the active config
+    int last_channel;                  // Channel of the previous conversion, -1 for none
+    uint32_t gain_changed;             // Channels whose PGA changed since their last sample
+    struct ads1115_stream_reconfig staged; // Applied at the next conversion
+    int staged_pending;
+    uint16_t staged_gen;               // Generation of the last staged config
+};
+
+struct ads1115_dev *ads1115_dev_alloc(const struct ads1115_backend_ops *ops);
+void ads1115_sleep_us(unsigned int us);
+
+// Sleep on the device's clock
+void ads1115_dev_sleep_us(struct ads1115_dev *dev, unsigned int us);
+
+// Userspace streaming shared by backends that convert in the caller's
+// context: one pass over the enabled channels per call.
+int ads1115_soft_stream_start(struct ads1115_dev *dev, const struct ads1115_stream_config *cfg);
+ssize_t ads1115_soft_stream_read(struct ads1115_dev *dev, struct ads1115_sample *buf, size_t count);
+int ads1115_soft_stream_stop(struct ads1115_dev *dev);
+int ads1115_soft_stream_reconfig(struct ads1115_dev *dev, const struct ads1115_stream_reconfig *rc);
+
+#endif
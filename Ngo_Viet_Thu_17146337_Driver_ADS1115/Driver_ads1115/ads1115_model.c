@@ -0,0 +1,408 @@
+#ifdef __KERNEL__
+#include <linux/kernel.h>
+#include <linux/math64.h>
+#include <linux/errno.h>
+#else
+#include <errno.h>
+#include <stddef.h>
+#endif
+
+#include "ads1115_model.h"
+
+#ifndef __KERNEL__
+#define div_u64(a, b)     ((u64)(a) / (u32)(b))
+#define div_s64(a, b)     ((s64)(a) / (s32)(b))
+#define div64_u64(a, b)   ((u64)(a) / (u64)(b))
+static inline u64 div_u64_rem(u64 a, u32 b, u32 *rem) { *rem = a % b; return a / b; }
+#endif
+
+// Config register fields
+#define MODEL_CONFIG_OS        0x8000
+#define MODEL_CONFIG_MODE      0x0100 // 1 = single-shot / power-down
+#define MODEL_CONFIG_COMP_MODE 0x0010 // 1 = window comparator
+#define MODEL_CONFIG_COMP_POL  0x0008 // 1 = active high
+#define MODEL_CONFIG_COMP_LAT  0x0004 // 1 = latching
+#define MODEL_CONFIG_COMP_QUE  0x0003 // 3 = comparator disabled
+#define MODEL_MUX(cfg)         (((cfg) >> 12) & 0x7)
+#define MODEL_PGA(cfg)         (((cfg) >> 9) & 0x7)
+#define MODEL_DR(cfg)          (((cfg) >> 5) & 0x7)
+
+#define MODEL_PIN_GND          0xff
+#define MODEL_PIN_MARGIN_UV    300000 // Inputs clamp 0.3 V beyond the rails
+
+// Register pointer values
+enum {
+    MODEL_REG_CONVERSION,
+    MODEL_REG_CONFIG,
+    MODEL_REG_LO_THRESH,
+    MODEL_REG_HI_THRESH,
+};
+
+static const u32 model_data_rate_sps[] = { 8, 16, 32, 64, 128, 250, 475, 860 };
+
+// Full-scale range in microvolts for each PGA code
+static const s32 model_fsr_uv[] = { 6144000, 4096000, 2048000, 1024000, 512000, 256000, 256000, 256000 };
+
+// Positive and negative pin for each MUX code
+static const u8 model_mux_pins[8][2] = {
+    { 0, 1 }, { 0, 3 }, { 1, 3 }, { 2, 3 },
+    { 0, MODEL_PIN_GND }, { 1, MODEL_PIN_GND }, { 2, MODEL_PIN_GND }, { 3, MODEL_PIN_GND },
+};
+
+// xorshift32, deterministic for a given seed
+static u32 model_xorshift(u32 *state)
+{
+    u32 x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// sin() of a 16-bit phase in Q15, Bhaskara I approximation (error < 0.2%)
+static s32 model_sin_q15(u32 phase)
+{
+    u64 p = phase & 0x7fff, y = p * (0x8000 - p);
+    s32 s = (s32)div64_u64(16 * y * 32767, 5ull * 0x8000 * 0x8000 - 4 * y);
+
+    return (phase & 0x8000) ? -s : s;
+}
+
+s32 ads1115_model_signal_uv(const struct ads1115_model_signal *sig, u64 now_ns)
+{
+    u32 rem = 0;
+
+    if (sig->type != ADS1115_SIGNAL_CONST && sig->period_us)
+        div_u64_rem(div_u64(now_ns, 1000), sig->period_us, &rem);
+
+    switch (sig->type) {
+    case ADS1115_SIGNAL_RAMP:
+        if (!sig->period_us)
+            break;
+        return sig->offset_uv + (s32)div_s64((s64)sig->amplitude_uv * rem, sig->period_us);
+    case ADS1115_SIGNAL_SINE:
+        if (!sig->period_us)
+            break;
+        return sig->offset_uv +
+               (s32)div_s64((s64)sig->amplitude_uv *
+                            model_sin_q15((u32)div_u64((u64)rem << 16, sig->period_us)), 32767);
+    case ADS1115_SIGNAL_SQUARE:
+        return rem < sig->period_us / 2 ? sig->offset_uv + sig->amplitude_uv
+                                        : sig->offset_uv - sig->amplitude_uv;
+    default:
+        break;
+    }
+    return sig->offset_uv;
+}
+
+s32 ads1115_model_replay_uv(const struct ads1115_model *m, u8 pin, u64 now_ns)
+{
+    const struct ads1115_model_replay *r = &m->replay[pin];
+    u64 t, span;
+    u32 lo, hi, mid;
+
+    if (!r->count)
+        return 0;
+
+    t = now_ns > m->replay_start_ns ? now_ns - m->replay_start_ns : 0;
+    if (m->replay_speed_pct != 100 && m->replay_speed_pct)
+        t = div_u64(t, 100) * m->replay_speed_pct;
+    // A loop lasts one mean sample interval past the last point, so the
+    // last value is held as long as the others
+    span = r->points[r->count - 1].time_ns;
+    if (r->count > 1)
+        span += div_u64(span, r->count - 1);
+    if (m->replay_loop && span && t >= span)
+        t -= div64_u64(t, span) * span;
+
+    // Last point at or before t
+    lo = 0;
+    hi = r->count;
+    while (hi - lo > 1) {
+        mid = lo + (hi - lo) / 2;
+        if (r->points[mid].time_ns <= t)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return r->points[lo].uv;
+}
+
+static s64 model_pin_uv(struct ads1115_model *m, u8 pin, u64 now_ns)
+{
+    const struct ads1115_model_signal *sig;
+    s64 uv;
+
+    if (pin == MODEL_PIN_GND)
+        return 0;
+
+    sig = &m->signals[pin];
+    uv = ads1115_model_signal_uv(sig, now_ns);
+    if (sig->type == ADS1115_SIGNAL_REPLAY)
+        uv += ads1115_model_replay_uv(m, pin, now_ns);
+    if (sig->noise_uv)
+        uv += (s64)(model_xorshift(&m->rng) % (2 * sig->noise_uv + 1)) - sig->noise_uv;
+
+    if (uv < -MODEL_PIN_MARGIN_UV)
+        uv = -MODEL_PIN_MARGIN_UV;
+    if (uv > (s64)m->vdd_uv + MODEL_PIN_MARGIN_UV)
+        uv = (s64)m->vdd_uv + MODEL_PIN_MARGIN_UV;
+    return uv;
+}
+
+static s16 model_convert(struct ads1115_model *m, u16 config, u64 now_ns)
+{
+    const u8 *pins = model_mux_pins[MODEL_MUX(config)];
+    s64 uv = model_pin_uv(m, pins[0], now_ns) - model_pin_uv(m, pins[1], now_ns);
+    s64 code = div_s64(uv * 32768, model_fsr_uv[MODEL_PGA(config)]);
+
+    if (code > 32767)
+        code = 32767;
+    if (code < -32768)
+        code = -32768;
+    return (s16)code;
+}
+
+// Conversion-ready mode: Hi_thresh MSB set and Lo_thresh MSB clear
+static bool model_rdy_mode(const struct ads1115_model *m)
+{
+    return (m->hi_thresh & 0x8000) && !(m->lo_thresh & 0x8000);
+}
+
+static void model_comparator(struct ads1115_model *m, s16 value)
+{
+    u16 cfg = m->active_config;
+    u8 que = cfg & MODEL_CONFIG_COMP_QUE;
+    bool window = cfg & MODEL_CONFIG_COMP_MODE;
+    bool beyond, inside;
+
+    if (que == MODEL_CONFIG_COMP_QUE)
+        return;
+
+    if (model_rdy_mode(m)) {
+        m->alert = true;
+        return;
+    }
+
+    beyond = value > (s16)m->hi_thresh || (window && value < (s16)m->lo_thresh);
+    inside = window ? value <= (s16)m->hi_thresh && value >= (s16)m->lo_thresh
+                    : value < (s16)m->lo_thresh;
+
+    if (beyond) {
+        if (m->que_count < 4)
+            m->que_count++;
+        if (m->que_count >= (1 << que)) // 1, 2 or 4 conversions
+            m->alert = true;
+    } else {
+        m->que_count = 0;
+        if (inside && !(cfg & MODEL_CONFIG_COMP_LAT))
+            m->alert = false;
+    }
+}
+
+static void model_start(struct ads1115_model *m, u64 now_ns)
+{
+    m->active_config = m->config;
+    m->converting = true;
+    m->conv_end_ns = now_ns + ads1115_model_conv_time_ns(m, m->active_config);
+    if (model_rdy_mode(m))
+        m->alert = false;
+}
+
+static void model_complete(struct ads1115_model *m)
+{
+    s16 value = model_convert(m, m->active_config, m->conv_end_ns);
+
+    m->conversion = (u16)value;
+    m->stats.conversions++;
+    model_comparator(m, value);
+}
+
+u64 ads1115_model_conv_time_ns(const struct ads1115_model *m, u16 config)
+{
+    return div_u64(1000000000ull * (u64)(1000000 + m->clock_ppm),
+                   model_data_rate_sps[MODEL_DR(config)] * 1000000u);
+}
+
+void ads1115_model_advance(struct ads1115_model *m, u64 now_ns)
+{
+    u64 period, behind;
+
+    while (m->converting && now_ns >= m->conv_end_ns) {
+        model_complete(m);
+
+        if (m->config & MODEL_CONFIG_MODE) {
+            m->converting = false; // Single-shot: power down
+            break;
+        }
+
+        // Continuous: the next conversion picks up the current config
+        m->active_config = m->config;
+        period = ads1115_model_conv_time_ns(m, m->active_config);
+        behind = now_ns - m->conv_end_ns;
+        if (behind > 2 * period) {
+            // Long idle gap: skip conversions nobody could have observed
+            m->stats.conversions += div64_u64(behind, period) - 1;
+            m->conv_end_ns += (div64_u64(behind, period) - 1) * period;
+        }
+        m->conv_end_ns += period;
+    }
+}
+
+static void model_write_config(struct ads1115_model *m, u64 now_ns, u16 value)
+{
+    m->config = value & ~MODEL_CONFIG_OS;
+    m->stats.config_writes++;
+
+    if (value & MODEL_CONFIG_MODE) {
+        if ((value & MODEL_CONFIG_OS) && !m->converting)
+            model_start(m, now_ns);
+    } else if (!m->converting) {
+        model_start(m, now_ns);
+    }
+    // A conversion in flight finishes with the config it started with
+}
+
+int ads1115_model_write(struct ads1115_model *m, u64 now_ns, const u8 *buf, u16 len)
+{
+    u16 value;
+
+    if (!len)
+        return 0;
+
+    ads1115_model_advance(m, now_ns);
+    m->pointer = buf[0] & 0x3;
+    if (len < 3)
+        return 0;
+
+    value = (buf[1] << 8) | buf[2];
+    switch (m->pointer) {
+    case MODEL_REG_CONFIG:
+        model_write_config(m, now_ns, value);
+        break;
+    case MODEL_REG_LO_THRESH:
+        m->lo_thresh = value;
+        break;
+    case MODEL_REG_HI_THRESH:
+        m->hi_thresh = value;
+        break;
+    default:
+        return -EINVAL; // Conversion register is read-only
+    }
+    return 0;
+}
+
+int ads1115_model_read(struct ads1115_model *m, u64 now_ns, u8 *buf, u16 len)
+{
+    u16 value;
+    u16 i;
+
+    ads1115_model_advance(m, now_ns);
+
+    switch (m->pointer) {
+    case MODEL_REG_CONVERSION:
+        value = m->conversion;
+        m->stats.result_reads++;
+        if (m->config & MODEL_CONFIG_COMP_LAT)
+            m->alert = false; // Reading the result clears a latched alert
+        break;
+    case MODEL_REG_CONFIG:
+        value = m->config;
+        if (!m->converting)
+            value |= MODEL_CONFIG_OS;
+        break;
+    case MODEL_REG_LO_THRESH:
+        value = m->lo_thresh;
+        break;
+    default:
+        value = m->hi_thresh;
+        break;
+    }
+
+    for (i = 0; i < len; i++)
+        buf[i] = (i & 1) ? value & 0xff : value >> 8;
+    return 0;
+}
+
+int ads1115_model_fault(struct ads1115_model *m)
+{
+    const struct ads1115_model_faults *f = &m->faults;
+    u32 r;
+    int ret;
+
+    if (f->hung) {
+        m->stats.faults++;
+        return -ETIMEDOUT;
+    }
+    if (!f->nak_ppm && !f->timeout_ppm && !f->busy_ppm)
+        return 0;
+
+    r = model_xorshift(&m->fault_rng) % 1000000;
+    if (r < f->nak_ppm)
+        ret = -ENXIO;
+    else if (r < f->nak_ppm + f->timeout_ppm)
+        ret = -ETIMEDOUT;
+    else if (r < f->nak_ppm + f->timeout_ppm + f->busy_ppm)
+        ret = -EBUSY;
+    else
+        return 0;
+
+    m->stats.faults++;
+    return ret;
+}
+
+bool ads1115_model_alert_pin(struct ads1115_model *m, u64 now_ns)
+{
+    ads1115_model_advance(m, now_ns);
+
+    if ((m->config & MODEL_CONFIG_COMP_QUE) == MODEL_CONFIG_COMP_QUE)
+        return true; // Comparator off, pin is high-Z and pulled up
+    return (m->config & MODEL_CONFIG_COMP_POL) ? m->alert : !m->alert;
+}
+
+void ads1115_model_reset(struct ads1115_model *m)
+{
+    m->pointer = MODEL_REG_CONVERSION;
+    m->config = ADS1115_MODEL_CONFIG_RESET & ~MODEL_CONFIG_OS;
+    m->conversion = 0;
+    m->lo_thresh = 0x8000;
+    m->hi_thresh = 0x7fff;
+    m->converting = false;
+    m->alert = false;
+    m->que_count = 0;
+    m->faults.hung = false;
+}
+
+void ads1115_model_init(struct ads1115_model *m, u32 seed)
+{
+    u8 i;
+
+    for (i = 0; i < ADS1115_MODEL_NUM_INPUTS; i++) {
+        m->signals[i].type = ADS1115_SIGNAL_CONST;
+        m->signals[i].offset_uv = 0;
+        m->signals[i].amplitude_uv = 0;
+        m->signals[i].period_us = 0;
+        m->signals[i].noise_uv = 0;
+        m->replay[i].points = NULL;
+        m->replay[i].count = 0;
+    }
+    m->replay_start_ns = 0;
+    m->replay_speed_pct = 100;
+    m->replay_loop = false;
+    m->stats.transactions = 0;
+    m->stats.config_writes = 0;
+    m->stats.conversions = 0;
+    m->stats.result_reads = 0;
+    m->stats.faults = 0;
+    m->faults.nak_ppm = 0;
+    m->faults.timeout_ppm = 0;
+    m->faults.busy_ppm = 0;
+    m->faults.stuck_us = 25000; // SMBus tTIMEOUT
+    m->clock_ppm = 0;
+    m->vdd_uv = 3300000;
+    m->rng = seed ? seed : 1;
+    m->fault_rng = m->rng ^ 0x5a5a5a5a;
+    ads1115_model_reset(m);
+}
@@ -0,0 +1,139 @@
+#ifndef ADS1115_MODEL_H
+#define ADS1115_MODEL_H
+
+// Register-level software model of the ADS1115. The same code runs in the
+// kernel test adapter (ads1115_stub.c) and in the userspace client library,
+// so the driver and the i2c-dev backend can be exercised without a board.
+// Time is passed in by the caller in nanoseconds.
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#include <stdbool.h>
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+#endif
+
+#define ADS1115_MODEL_NUM_INPUTS   4      // AIN0..AIN3
+#define ADS1115_MODEL_CONFIG_RESET 0x8583 // Config register power-on value
+#define ADS1115_MODEL_GENERAL_CALL 0x00   // General call address
+#define ADS1115_MODEL_RESET_CMD    0x06   // General call reset command
+
+enum ads1115_model_signal_type {
+    ADS1115_SIGNAL_CONST,  // offset_uv
+    ADS1115_SIGNAL_RAMP,   // Sawtooth from offset_uv to offset_uv + amplitude_uv
+    ADS1115_SIGNAL_SINE,   // offset_uv + amplitude_uv * sin(t)
+    ADS1115_SIGNAL_SQUARE, // offset_uv +/- amplitude_uv
+    ADS1115_SIGNAL_REPLAY, // offset_uv + the pin's recording (struct ads1115_model_replay)
+};
+
+// Signal applied to one input pin, relative to GND
+struct ads1115_model_signal {
+    u32 type;         // enum ads1115_model_signal_type
+    s32 offset_uv;    // DC level in microvolts
+    s32 amplitude_uv; // Peak amplitude in microvolts
+    u32 period_us;    // Period of ramp, sine and square signals
+    u32 noise_uv;     // Peak uniform noise added to every conversion
+};
+
+// One point of a recorded input. 16 bytes, the record format the stub
+// accepts through debugfs.
+struct ads1115_model_replay_point {
+    u64 time_ns; // From the start of the recording, ascending
+    s32 uv;      // Pin voltage until the next point
+    u32 reserved;
+};
+
+// Recording played back on one pin. The points are owned by whoever set
+// them; the pin holds each value until the next point.
+struct ads1115_model_replay {
+    const struct ads1115_model_replay_point *points;
+    u32 count;
+};
+
+// Bus faults injected by the adapter, rates in parts per million of transfers
+struct ads1115_model_faults {
+    u32 nak_ppm;     // Address not acknowledged (-ENXIO)
+    u32 timeout_ppm; // Chip stretches SCL until the adapter gives up (-ETIMEDOUT)
+    u32 busy_ppm;    // Bus held busy by another master (-EBUSY)
+    u32 stuck_us;    // Time a timeout or busy fault holds the bus
+    bool hung;       // Chip holds SDA low: every transfer times out until a general call reset
+};
+
+struct ads1115_model_stats {
+    u64 transactions;  // Bus transfers addressed to the chip, counted by the adapter
+    u64 config_writes; // Writes to the config register
+    u64 conversions;   // Completed conversions
+    u64 result_reads;  // Reads of the conversion register
+    u64 faults;        // Transfers failed by fault injection
+};
+
+struct ads1115_model {
+    // Registers
+    u8 pointer;
+    u16 config;
+    u16 conversion;
+    u16 lo_thresh;
+    u16 hi_thresh;
+
+    // Conversion engine
+    bool converting;    // A conversion is in flight
+    u16 active_config;  // Config latched at conversion start
+    u64 conv_end_ns;    // Completion time of the conversion in flight
+    s32 clock_ppm;      // Internal oscillator error, positive is slower
+    u32 vdd_uv;         // Supply voltage, inputs clamp at VDD + 0.3 V
+
+    // Comparator and ALERT/RDY pin
+    bool alert;         // Comparator output asserted
+    u8 que_count;       // Consecutive conversions beyond threshold
+
+    struct ads1115_model_signal signals[ADS1115_MODEL_NUM_INPUTS];
+    struct ads1115_model_replay replay[ADS1115_MODEL_NUM_INPUTS];
+    u64 replay_start_ns;  // Time the recordings start playing
+    u32 replay_speed_pct; // Playback speed, 100 is as recorded
+    bool replay_loop;     // Start over after the last point instead of holding it
+    struct ads1115_model_faults faults;
+    u32 rng;            // Noise generator state
+    u32 fault_rng;      // Fault generator state, separate so faults do not change the noise
+    struct ads1115_model_stats stats;
+};
+
+void ads1115_model_init(struct ads1115_model *m, u32 seed);
+
+// Power-on reset, as after a general call reset
+void ads1115_model_reset(struct ads1115_model *m);
+
+// Run conversions that completed by now_ns
+void ads1115_model_advance(struct ads1115_model *m, u64 now_ns);
+
+// One I2C write message: pointer byte, optionally followed by a register value
+int ads1115_model_write(struct ads1115_model *m, u64 now_ns, const u8 *buf, u16 len);
+
+// One I2C read message from the register selected by the pointer
+int ads1115_model_read(struct ads1115_model *m, u64 now_ns, u8 *buf, u16 len);
+
+// Decide the fate of one bus transfer: 0, or the error the adapter returns.
+// Timeout and busy faults hold the bus for faults.stuck_us, which the
+// adapter has to charge.
+int ads1115_model_fault(struct ads1115_model *m);
+
+// ALERT/RDY pin level (true is high) after applying COMP_POL
+bool ads1115_model_alert_pin(struct ads1115_model *m, u64 now_ns);
+
+// Conversion time in nanoseconds for the DR code in a config value
+u64 ads1115_model_conv_time_ns(const struct ads1115_model *m, u16 config);
+
+// Voltage on an input pin at time now_ns, without noise. Replayed pins
+// return offset_uv only, see ads1115_model_replay_uv().
+s32 ads1115_model_signal_uv(const struct ads1115_model_signal *sig, u64 now_ns);
+
+// Recorded voltage on an input pin at time now_ns, 0 without a recording
+s32 ads1115_model_replay_uv(const struct ads1115_model *m, u8 pin, u64 now_ns);
+
+#endif
@@ -0,0 +1,479 @@
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/i2c.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/delay.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+
+#include "ads1115_model.h"
+
+// Test adapter in the style of i2c-stub: a virtual I2C bus with software
+// ADS1115 chips behind it, so ads1115_driver can be loaded and benchmarked on
+// a machine without the hardware. Signals, counters and fault injection
+// rates are under /sys/kernel/debug/ads1115_stub/<addr>/, along with
+// recordings to play back on the inputs (ainN_replay, see
+// replay_ads1115.c).
+
+#define STUB_NAME       "ads1115_stub" // Name for logging and debugfs
+#define STUB_MAX_CHIPS  4              // One per address pin strapping
+#define STUB_REPLAY_MAX (1u << 22)     // Points in one recording, 64 MiB
+
+static unsigned short chip_addr[STUB_MAX_CHIPS] = { 0x48 };
+static int num_chips = 1;
+module_param_array(chip_addr, ushort, &num_chips, 0444);
+MODULE_PARM_DESC(chip_addr, "Chip addresses (0x48-0x4b)");
+
+static bool instantiate = true;
+module_param(instantiate, bool, 0444);
+MODULE_PARM_DESC(instantiate, "Create ads1115 client devices on load");
+
+static unsigned int seed = 1;
+module_param(seed, uint, 0444);
+MODULE_PARM_DESC(seed, "Noise generator seed, chip n uses seed + n");
+
+struct stub_chip;
+
+// Input pin behind an ainN_replay file
+struct stub_replay {
+    struct stub_chip *chip;
+    u8 pin;
+};
+
+struct stub_chip {
+    u16 addr;
+    struct ads1115_model model; // Replay points are kvmalloc'd and owned by the chip
+    struct i2c_client *client; // Instantiated ads1115 device, if any
+    struct dentry *dir;
+    struct stub_replay replay[ADS1115_MODEL_NUM_INPUTS];
+};
+
+// Recording being written through one open ainN_replay file
+struct stub_replay_upload {
+    struct stub_replay *target;
+    struct ads1115_model_replay_point *points;
+    u32 count;
+    u32 capacity;
+};
+
+static struct stub_chip *stub_chips; // Software chips on the adapter
+static DEFINE_MUTEX(stub_lock); // Serialises model access
+static struct dentry *stub_debugfs; // debugfs root
+
+static struct stub_chip *stub_find_chip(u16 addr)
+{
+    int i;
+
+    for (i = 0; i < num_chips; i++)
+        if (stub_chips[i].addr == addr)
+            return &stub_chips[i];
+    return NULL;
+}
+
+// Injected fault for one transfer. Timeouts and a busy bus hold the adapter
+// as long as the real condition would.
+static int stub_fault(struct stub_chip *chip)
+{
+    int ret = ads1115_model_fault(&chip->model);
+
+    if (ret == -ETIMEDOUT || ret == -EBUSY)
+        usleep_range(chip->model.faults.stuck_us, chip->model.faults.stuck_us + 100);
+    return ret;
+}
+
+static s32 stub_smbus_xfer(struct i2c_adapter *adap, u16 addr, unsigned short flags,
+                           char read_write, u8 command, int size, union i2c_smbus_data *data)
+{
+    struct stub_chip *chip = stub_find_chip(addr);
+    u8 buf[3];
+    u64 now;
+    s32 ret = 0;
+
+    if (addr == ADS1115_MODEL_GENERAL_CALL && size == I2C_SMBUS_BYTE &&
+        read_write == I2C_SMBUS_WRITE && command == ADS1115_MODEL_RESET_CMD) {
+        mutex_lock(&stub_lock);
+        for (chip = stub_chips; chip < stub_chips + num_chips; chip++)
+            ads1115_model_reset(&chip->model);
+        mutex_unlock(&stub_lock);
+        return 0;
+    }
+    if (!chip)
+        return -ENODEV;
+
+    mutex_lock(&stub_lock);
+    now = ktime_get_ns();
+    chip->model.stats.transactions++;
+    ret = stub_fault(chip);
+    if (ret)
+        goto out;
+
+    switch (size) {
+    case I2C_SMBUS_QUICK:
+        break;
+    case I2C_SMBUS_BYTE:
+        if (read_write == I2C_SMBUS_WRITE) {
+            ret = ads1115_model_write(&chip->model, now, &command, 1);
+        } else {
+            ret = ads1115_model_read(&chip->model, now, buf, 1);
+            data->byte = buf[0];
+        }
+        break;
+    case I2C_SMBUS_WORD_DATA:
+        if (read_write == I2C_SMBUS_WRITE) {
+            // SMBus words go out low byte first
+            buf[0] = command;
+            buf[1] = data->word & 0xff;
+            buf[2] = data->word >> 8;
+            ret = ads1115_model_write(&chip->model, now, buf, 3);
+        } else {
+            ret = ads1115_model_write(&chip->model, now, &command, 1);
+            if (!ret)
+                ret = ads1115_model_read(&chip->model, now, buf, 2);
+            data->word = buf[0] | (buf[1] << 8);
+        }
+        break;
+    default:
+        ret = -EOPNOTSUPP;
+        break;
+    }
+
+out:
+    mutex_unlock(&stub_lock);
+    return ret;
+}
+
+static int stub_master_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
+{
+    struct stub_chip *chip, *last = NULL;
+    u64 now;
+    int i, ret = 0;
+
+    mutex_lock(&stub_lock);
+    now = ktime_get_ns();
+    for (i = 0; i < num && !ret; i++) {
+        if (msgs[i].addr == ADS1115_MODEL_GENERAL_CALL) {
+            if (!(msgs[i].flags & I2C_M_RD) && msgs[i].len &&
+                msgs[i].buf[0] == ADS1115_MODEL_RESET_CMD) {
+                for (chip = stub_chips; chip < stub_chips + num_chips; chip++)
+                    ads1115_model_reset(&chip->model);
+            }
+            continue;
+        }
+
+        chip = stub_find_chip(msgs[i].addr);
+        if (!chip) {
+            ret = -ENXIO; // No ACK on the address
+            break;
+        }
+        if (chip != last) {
+            chip->model.stats.transactions++;
+            ret = stub_fault(chip);
+            if (ret)
+                break;
+        }
+        last = chip;
+
+        if (msgs[i].flags & I2C_M_RD)
+            ret = ads1115_model_read(&chip->model, now, msgs[i].buf, msgs[i].len);
+        else
+            ret = ads1115_model_write(&chip->model, now, msgs[i].buf, msgs[i].len);
+    }
+    mutex_unlock(&stub_lock);
+
+    return ret ? ret : num;
+}
+
+static u32 stub_functionality(struct i2c_adapter *adap)
+{
+    return I2C_FUNC_I2C | I2C_FUNC_SMBUS_QUICK | I2C_FUNC_SMBUS_BYTE |
+           I2C_FUNC_SMBUS_WORD_DATA;
+}
+
+static const struct i2c_algorithm stub_algorithm = {
+    .master_xfer   = stub_master_xfer,
+    .smbus_xfer    = stub_smbus_xfer,
+    .functionality = stub_functionality,
+};
+
+static struct i2c_adapter stub_adapter = {
+    .owner = THIS_MODULE,
+    .class = I2C_CLASS_HWMON,
+    .algo  = &stub_algorithm,
+    .name  = "ADS1115 stub adapter",
+};
+
+// debugfs: ainN takes "<type> <offset_uv> <amplitude_uv> <period_us> <noise_uv>"
+static int stub_signal_show(struct seq_file *s, void *unused)
+{
+    struct ads1115_model_signal *sig = s->private;
+
+    mutex_lock(&stub_lock);
+    seq_printf(s, "%u %d %d %u %u\n", sig->type, sig->offset_uv, sig->amplitude_uv,
+               sig->period_us, sig->noise_uv);
+    mutex_unlock(&stub_lock);
+    return 0;
+}
+
+static int stub_signal_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, stub_signal_show, inode->i_private);
+}
+
+static ssize_t stub_signal_write(struct file *file, const char __user *ubuf,
+                                 size_t len, loff_t *ppos)
+{
+    struct ads1115_model_signal *sig = ((struct seq_file *)file->private_data)->private;
+    struct ads1115_model_signal new_sig = { 0 };
+    char buf[96];
+
+    if (len >= sizeof(buf))
+        return -EINVAL;
+    if (copy_from_user(buf, ubuf, len))
+        return -EFAULT;
+    buf[len] = '\0';
+
+    if (sscanf(buf, "%u %d %d %u %u", &new_sig.type, &new_sig.offset_uv,
+               &new_sig.amplitude_uv, &new_sig.period_us, &new_sig.noise_uv) < 2 ||
+        new_sig.type > ADS1115_SIGNAL_REPLAY)
+        return -EINVAL;
+
+    mutex_lock(&stub_lock);
+    *sig = new_sig;
+    mutex_unlock(&stub_lock);
+    return len;
+}
+
+static const struct file_operations stub_signal_fops = {
+    .owner   = THIS_MODULE,
+    .open    = stub_signal_open,
+    .read    = seq_read,
+    .write   = stub_signal_write,
+    .llseek  = seq_lseek,
+    .release = single_release,
+};
+
+// ainN_replay takes struct ads1115_model_replay_point records in any number
+// of writes, each a whole number of records. The recording replaces the
+// pin's old one on close; closing without a write removes it.
+static int stub_replay_open(struct inode *inode, struct file *file)
+{
+    struct stub_replay_upload *up;
+
+    up = kzalloc(sizeof(*up), GFP_KERNEL);
+    if (!up)
+        return -ENOMEM;
+    up->target = inode->i_private;
+    file->private_data = up;
+    return nonseekable_open(inode, file);
+}
+
+static ssize_t stub_replay_write(struct file *file, const char __user *ubuf,
+                                 size_t len, loff_t *ppos)
+{
+    struct stub_replay_upload *up = file->private_data;
+    struct ads1115_model_replay_point *points;
+    u32 n = len / sizeof(*points), i, capacity;
+
+    if (len % sizeof(*points) || n > STUB_REPLAY_MAX - up->count)
+        return -EINVAL;
+
+    if (up->count + n > up->capacity) {
+        capacity = max(up->count + n, min(2 * up->capacity, STUB_REPLAY_MAX));
+        points = kvmalloc_array(capacity, sizeof(*points), GFP_KERNEL);
+        if (!points)
+            return -ENOMEM;
+        if (up->count)
+            memcpy(points, up->points, up->count * sizeof(*points));
+        kvfree(up->points);
+        up->points = points;
+        up->capacity = capacity;
+    }
+
+    if (copy_from_user(up->points + up->count, ubuf, len))
+        return -EFAULT;
+    for (i = up->count ? up->count : 1; i < up->count + n; i++)
+        if (up->points[i].time_ns < up->points[i - 1].time_ns)
+            return -EINVAL;
+    up->count += n;
+    return len;
+}
+
+static int stub_replay_release(struct inode *inode, struct file *file)
+{
+    struct stub_replay_upload *up = file->private_data;
+    struct ads1115_model_replay *r = &up->target->chip->model.replay[up->target->pin];
+    const struct ads1115_model_replay_point *old;
+
+    if (!up->count) {
+        kvfree(up->points);
+        up->points = NULL;
+    }
+    mutex_lock(&stub_lock);
+    old = r->points;
+    r->points = up->points;
+    r->count = up->count;
+    mutex_unlock(&stub_lock);
+
+    kvfree(old);
+    kfree(up);
+    return 0;
+}
+
+static const struct file_operations stub_replay_fops = {
+    .owner   = THIS_MODULE,
+    .open    = stub_replay_open,
+    .write   = stub_replay_write,
+    .release = stub_replay_release,
+};
+
+// Reads give the start of playback, any write restarts it now
+static int stub_replay_start_get(void *data, u64 *val)
+{
+    *val = ((struct stub_chip *)data)->model.replay_start_ns;
+    return 0;
+}
+
+static int stub_replay_start_set(void *data, u64 val)
+{
+    mutex_lock(&stub_lock);
+    ((struct stub_chip *)data)->model.replay_start_ns = ktime_get_ns();
+    mutex_unlock(&stub_lock);
+    return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(stub_replay_start_fops, stub_replay_start_get, stub_replay_start_set, "%llu\n");
+
+static int stub_stats_show(struct seq_file *s, void *unused)
+{
+    struct stub_chip *chip = s->private;
+
+    mutex_lock(&stub_lock);
+    seq_printf(s, "transactions %llu\nconfig_writes %llu\nconversions %llu\nresult_reads %llu\n"
+               "faults %llu\n",
+               chip->model.stats.transactions, chip->model.stats.config_writes,
+               chip->model.stats.conversions, chip->model.stats.result_reads,
+               chip->model.stats.faults);
+    mutex_unlock(&stub_lock);
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(stub_stats);
+
+static int stub_clock_ppm_get(void *data, u64 *val)
+{
+    *val = (s64)((struct stub_chip *)data)->model.clock_ppm;
+    return 0;
+}
+
+static int stub_clock_ppm_set(void *data, u64 val)
+{
+    if ((s64)val <= -1000000 || (s64)val >= 1000000)
+        return -EINVAL;
+    mutex_lock(&stub_lock);
+    ((struct stub_chip *)data)->model.clock_ppm = (s32)val;
+    mutex_unlock(&stub_lock);
+    return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(stub_clock_ppm_fops, stub_clock_ppm_get, stub_clock_ppm_set, "%lld\n");
+
+static void stub_debugfs_init(struct stub_chip *chip)
+{
+    char name[16];
+    int i;
+
+    snprintf(name, sizeof(name), "0x%02x", chip->addr);
+    chip->dir = debugfs_create_dir(name, stub_debugfs);
+    for (i = 0; i < ADS1115_MODEL_NUM_INPUTS; i++) {
+        snprintf(name, sizeof(name), "ain%d", i);
+        debugfs_create_file(name, 0600, chip->dir, &chip->model.signals[i], &stub_signal_fops);
+        chip->replay[i].chip = chip;
+        chip->replay[i].pin = i;
+        snprintf(name, sizeof(name), "ain%d_replay", i);
+        debugfs_create_file(name, 0200, chip->dir, &chip->replay[i], &stub_replay_fops);
+    }
+    debugfs_create_file_unsafe("replay_start", 0600, chip->dir, chip, &stub_replay_start_fops);
+    debugfs_create_u32("replay_speed_pct", 0600, chip->dir, &chip->model.replay_speed_pct);
+    debugfs_create_bool("replay_loop", 0600, chip->dir, &chip->model.replay_loop);
+    debugfs_create_file("stats", 0400, chip->dir, chip, &stub_stats_fops);
+    debugfs_create_u32("vdd_uv", 0600, chip->dir, &chip->model.vdd_uv);
+    debugfs_create_file_unsafe("clock_ppm", 0600, chip->dir, chip, &stub_clock_ppm_fops);
+    debugfs_create_u32("nak_ppm", 0600, chip->dir, &chip->model.faults.nak_ppm);
+    debugfs_create_u32("timeout_ppm", 0600, chip->dir, &chip->model.faults.timeout_ppm);
+    debugfs_create_u32("busy_ppm", 0600, chip->dir, &chip->model.faults.busy_ppm);
+    debugfs_create_u32("stuck_us", 0600, chip->dir, &chip->model.faults.stuck_us);
+    debugfs_create_bool("hung", 0600, chip->dir, &chip->model.faults.hung);
+}
+
+static int __init ads1115_stub_init(void)
+{
+    struct i2c_board_info info = { I2C_BOARD_INFO("ads1115", 0) };
+    struct stub_chip *chip;
+    int i, ret;
+
+    for (i = 0; i < num_chips; i++) {
+        if (chip_addr[i] < 0x48 || chip_addr[i] > 0x4b) {
+            pr_err(STUB_NAME ": Invalid chip address 0x%02x\n", chip_addr[i]);
+            return -EINVAL;
+        }
+    }
+
+    stub_chips = kcalloc(num_chips, sizeof(*stub_chips), GFP_KERNEL);
+    if (!stub_chips)
+        return -ENOMEM;
+
+    stub_debugfs = debugfs_create_dir(STUB_NAME, NULL);
+    for (i = 0; i < num_chips; i++) {
+        chip = &stub_chips[i];
+        chip->addr = chip_addr[i];
+        ads1115_model_init(&chip->model, seed + i);
+        stub_debugfs_init(chip);
+    }
+
+    ret = i2c_add_adapter(&stub_adapter);
+    if (ret)
+        goto fail;
+
+    if (!instantiate)
+        return 0;
+
+    for (i = 0; i < num_chips; i++) {
+        chip = &stub_chips[i];
+        info.addr = chip->addr;
+        chip->client = i2c_new_client_device(&stub_adapter, &info);
+        if (IS_ERR(chip->client)) {
+            pr_warn(STUB_NAME ": Cannot instantiate chip 0x%02x: %ld\n",
+                    chip->addr, PTR_ERR(chip->client));
+            chip->client = NULL;
+        }
+    }
+
+    return 0;
+
+fail:
+    debugfs_remove_recursive(stub_debugfs);
+    kfree(stub_chips);
+    return ret;
+}
+
+static void __exit ads1115_stub_exit(void)
+{
+    int i, j;
+
+    for (i = 0; i < num_chips; i++)
+        i2c_unregister_device(stub_chips[i].client);
+    i2c_del_adapter(&stub_adapter);
+    debugfs_remove_recursive(stub_debugfs);
+    for (i = 0; i < num_chips; i++)
+        for (j = 0; j < ADS1115_MODEL_NUM_INPUTS; j++)
+            kvfree(stub_chips[i].model.replay[j].points);
+    kfree(stub_chips);
+}
+
+module_init(ads1115_stub_init);
+module_exit(ads1115_stub_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Ngo_Viet_Thu");
+MODULE_DESCRIPTION("Software ADS1115 chips on a virtual I2C adapter");
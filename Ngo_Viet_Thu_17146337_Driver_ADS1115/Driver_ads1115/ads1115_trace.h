@@ -0,0 +1,140 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM ads1115
+
+#if !defined(_ADS1115_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _ADS1115_TRACE_H
+
+#include <linux/tracepoint.h>
+#include <linux/i2c.h>
+
+// Conversion lifecycle events. Durations are in nanoseconds, so a slow read
+// can be split into bus time (xfer_ns), conversion wait (wait_ns) and time
+// spent queued before userspace picked the sample up (age_ns).
+
+// Config register written, conversion started
+TRACE_EVENT(ads1115_conv_start,
+    TP_PROTO(struct i2c_client *client, unsigned int channel, u16 config, u64 xfer_ns),
+    TP_ARGS(client, channel, config, xfer_ns),
+    TP_STRUCT__entry(
+        __string(dev, dev_name(&client->dev))
+        __field(u8, channel)
+        __field(u16, config)
+        __field(u64, xfer_ns)
+    ),
+    TP_fast_assign(
+        __assign_str(dev, dev_name(&client->dev));
+        __entry->channel = channel;
+        __entry->config = config;
+        __entry->xfer_ns = xfer_ns;
+    ),
+    TP_printk("%s ch=%u config=0x%04x mux=%u pga=%u dr=%u xfer_ns=%llu",
+              __get_str(dev), __entry->channel, __entry->config,
+              (__entry->config >> 12) & 0x7, (__entry->config >> 9) & 0x7,
+              (__entry->config >> 5) & 0x7, __entry->xfer_ns)
+);
+
+// Conversion considered complete, wait_ns after the config write
+TRACE_EVENT(ads1115_conv_ready,
+    TP_PROTO(struct i2c_client *client, unsigned int channel, u64 wait_ns),
+    TP_ARGS(client, channel, wait_ns),
+    TP_STRUCT__entry(
+        __string(dev, dev_name(&client->dev))
+        __field(u8, channel)
+        __field(u64, wait_ns)
+    ),
+    TP_fast_assign(
+        __assign_str(dev, dev_name(&client->dev));
+        __entry->channel = channel;
+        __entry->wait_ns = wait_ns;
+    ),
+    TP_printk("%s ch=%u wait_ns=%llu", __get_str(dev), __entry->channel, __entry->wait_ns)
+);
+
+// Conversion register read back
+TRACE_EVENT(ads1115_result_read,
+    TP_PROTO(struct i2c_client *client, unsigned int channel, s16 value, u64 xfer_ns, int ret),
+    TP_ARGS(client, channel, value, xfer_ns, ret),
+    TP_STRUCT__entry(
+        __string(dev, dev_name(&client->dev))
+        __field(u8, channel)
+        __field(s16, value)
+        __field(u64, xfer_ns)
+        __field(int, ret)
+    ),
+    TP_fast_assign(
+        __assign_str(dev, dev_name(&client->dev));
+        __entry->channel = channel;
+        __entry->value = value;
+        __entry->xfer_ns = xfer_ns;
+        __entry->ret = ret;
+    ),
+    TP_printk("%s ch=%u value=%d xfer_ns=%llu ret=%d", __get_str(dev), __entry->channel,
+              __entry->value, __entry->xfer_ns, __entry->ret)
+);
+
+// Sample stored in the stream ring (dropped when the ring was full)
+TRACE_EVENT(ads1115_sample_enqueue,
+    TP_PROTO(struct i2c_client *client, unsigned int channel, u16 seq, unsigned int fill, bool dropped),
+    TP_ARGS(client, channel, seq, fill, dropped),
+    TP_STRUCT__entry(
+        __string(dev, dev_name(&client->dev))
+        __field(u8, channel)
+        __field(u16, seq)
+        __field(unsigned int, fill)
+        __field(bool, dropped)
+    ),
+    TP_fast_assign(
+        __assign_str(dev, dev_name(&client->dev));
+        __entry->channel = channel;
+        __entry->seq = seq;
+        __entry->fill = fill;
+        __entry->dropped = dropped;
+    ),
+    TP_printk("%s ch=%u seq=%u fill=%u%s", __get_str(dev), __entry->channel, __entry->seq,
+              __entry->fill, __entry->dropped ? " dropped" : "")
+);
+
+// Samples copied out of the ring by read() or splice()
+TRACE_EVENT(ads1115_sample_dequeue,
+    TP_PROTO(struct i2c_client *client, unsigned int count, u64 age_ns),
+    TP_ARGS(client, count, age_ns),
+    TP_STRUCT__entry(
+        __string(dev, dev_name(&client->dev))
+        __field(unsigned int, count)
+        __field(u64, age_ns)
+    ),
+    TP_fast_assign(
+        __assign_str(dev, dev_name(&client->dev));
+        __entry->count = count;
+        __entry->age_ns = age_ns;
+    ),
+    TP_printk("%s count=%u oldest_age_ns=%llu", __get_str(dev), __entry->count, __entry->age_ns)
+);
+
+// Sampler switched to a staged config at a conversion boundary
+TRACE_EVENT(ads1115_stream_reconfig,
+    TP_PROTO(struct i2c_client *client, u16 generation, u32 channel_mask, unsigned int data_rate),
+    TP_ARGS(client, generation, channel_mask, data_rate),
+    TP_STRUCT__entry(
+        __string(dev, dev_name(&client->dev))
+        __field(u16, generation)
+        __field(u32, channel_mask)
+        __field(u8, data_rate)
+    ),
+    TP_fast_assign(
+        __assign_str(dev, dev_name(&client->dev));
+        __entry->generation = generation;
+        __entry->channel_mask = channel_mask;
+        __entry->data_rate = data_rate;
+    ),
+    TP_printk("%s generation=%u mask=0x%x dr=%u", __get_str(dev), __entry->generation,
+              __entry->channel_mask, __entry->data_rate)
+);
+
+#endif
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE ads1115_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,605 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "ads1115_tsfile.h"
+#include "ads1115_codec.h"
+
+#define TS_ALIGN(x)  (((x) + 7) & ~(size_t)7)
+#define TS_STREAMS   (ADS1115_TS_MAX_DEVICES * ADS1115_NUM_CHANNELS)
+
+_Static_assert(sizeof(struct ads1115_ts_header) % 8 == 0, "ads1115_ts_header alignment");
+_Static_assert(sizeof(struct ads1115_ts_block) == 40, "ads1115_ts_block layout");
+_Static_assert(sizeof(struct ads1115_ts_index_entry) == 32, "ads1115_ts_index_entry layout");
+_Static_assert(sizeof(struct ads1115_ts_footer) == 16, "ads1115_ts_footer layout");
+
+// Samples of one (device, channel) waiting for their block to fill
+struct ts_pending {
+    uint32_t count;
+    uint16_t generation;       // Of every pending sample
+    uint64_t *timestamp_ns;
+    int16_t *value;
+    uint16_t *seq;
+    uint8_t *flags;
+};
+
+struct ads1115_ts_writer {
+    int fd;
+    uint64_t offset;                       // End of the data written so far
+    struct ads1115_ts_header hdr;
+    unsigned int encoding;                 // ADS1115_TS_ENC_* of new blocks
+    uint8_t *encoded;                      // Compressed payload of the block being written
+    struct ts_pending *pending[TS_STREAMS]; // Allocated on a channel's first sample
+    struct ads1115_ts_index_entry *index;
+    size_t index_entries;
+    size_t index_alloc;
+};
+
+struct ads1115_ts_reader {
+    const uint8_t *map;
+    size_t size;
+    const struct ads1115_ts_header *hdr;
+    const struct ads1115_ts_index_entry *index; // Into the map, or rebuilt
+    size_t index_entries;
+    struct ads1115_ts_index_entry *rebuilt;   // Index of a file without a footer
+    // Columns of the last compressed block decoded
+    const struct ads1115_ts_block *decoded;
+    uint64_t *timestamp_ns;
+    int16_t *value;
+    uint16_t *seq;
+    uint8_t *flags;
+};
+
+// Columns of one block, in the map for raw blocks
+struct ts_columns {
+    const uint64_t *timestamp_ns;
+    const int16_t *value;
+    const uint16_t *seq;
+    const uint8_t *flags;
+};
+
+// Raw payload size for count samples, padding included
+static size_t ts_raw_size(uint32_t count) {
+    return TS_ALIGN((size_t)count * (sizeof(uint64_t) + sizeof(int16_t) + sizeof(uint16_t) + sizeof(uint8_t)));
+}
+
+static int ts_write_all(int fd, struct iovec *iov, int iovcnt, size_t len) {
+    ssize_t n;
+
+    while (len) {
+        n = writev(fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -errno;
+        }
+        len -= n;
+        // Short write: skip what went out and retry the rest
+        while (iovcnt && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt) {
+            iov->iov_base = (uint8_t *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return 0;
+}
+
+static struct ts_pending *ts_pending_alloc(uint32_t block_samples) {
+    struct ts_pending *p = calloc(1, sizeof(*p));
+
+    if (!p)
+        return NULL;
+    p->timestamp_ns = malloc(block_samples * sizeof(*p->timestamp_ns));
+    p->value = malloc(block_samples * sizeof(*p->value));
+    p->seq = malloc(block_samples * sizeof(*p->seq));
+    p->flags = malloc(block_samples * sizeof(*p->flags));
+    if (!p->timestamp_ns || !p->value || !p->seq || !p->flags) {
+        free(p->timestamp_ns);
+        free(p->value);
+        free(p->seq);
+        free(p->flags);
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+static void ts_pending_free(struct ts_pending *p) {
+    if (!p)
+        return;
+    free(p->timestamp_ns);
+    free(p->value);
+    free(p->seq);
+    free(p->flags);
+    free(p);
+}
+
+// Write one block from the pending samples of a stream and index it
+static int ts_flush_block(struct ads1115_ts_writer *w, unsigned int stream) {
+    static const uint8_t zeros[8];
+    struct ts_pending *p = w->pending[stream];
+    struct ads1115_ts_block blk = { .magic = ADS1115_TS_BLOCK_MAGIC };
+    struct ads1115_ts_index_entry *e;
+    struct iovec iov[6];
+    size_t cols, payload;
+    int iovcnt, ret;
+
+    if (!p || !p->count)
+        return 0;
+
+    if (w->index_entries == w->index_alloc) {
+        size_t alloc = w->index_alloc ? w->index_alloc * 2 : 64;
+        e = realloc(w->index, alloc * sizeof(*e));
+        if (!e)
+            return -ENOMEM;
+        w->index = e;
+        w->index_alloc = alloc;
+    }
+
+    blk.device = stream / ADS1115_NUM_CHANNELS;
+    blk.channel = stream % ADS1115_NUM_CHANNELS;
+    blk.encoding = w->encoding;
+    blk.count = p->count;
+    blk.generation = p->generation;
+    blk.first_ns = p->timestamp_ns[0];
+    blk.last_ns = p->timestamp_ns[p->count - 1];
+
+    iov[0] = (struct iovec){ &blk, sizeof(blk) };
+    if (w->encoding == ADS1115_TS_ENC_DELTA) {
+        cols = ads1115_codec_encode(p->timestamp_ns, p->value, p->seq, p->flags, p->count, w->encoded);
+        payload = TS_ALIGN(cols);
+        iov[1] = (struct iovec){ w->encoded, cols };
+        iov[2] = (struct iovec){ (void *)zeros, payload - cols };
+        iovcnt = 3;
+    } else {
+        cols = (size_t)p->count * (sizeof(uint64_t) + sizeof(int16_t) + sizeof(uint16_t) + sizeof(uint8_t));
+        payload = ts_raw_size(p->count);
+        iov[1] = (struct iovec){ p->timestamp_ns, p->count * sizeof(*p->timestamp_ns) };
+        iov[2] = (struct iovec){ p->value, p->count * sizeof(*p->value) };
+        iov[3] = (struct iovec){ p->seq, p->count * sizeof(*p->seq) };
+        iov[4] = (struct iovec){ p->flags, p->count * sizeof(*p->flags) };
+        iov[5] = (struct iovec){ (void *)zeros, payload - cols };
+        iovcnt = 6;
+    }
+    blk.payload_size = payload;
+    ret = ts_write_all(w->fd, iov, iovcnt, sizeof(blk) + payload);
+    if (ret < 0)
+        return ret;
+
+    e = &w->index[w->index_entries++];
+    memset(e, 0, sizeof(*e));
+    e->first_ns = blk.first_ns;
+    e->last_ns = blk.last_ns;
+    e->offset = w->offset;
+    e->count = blk.count;
+    e->device = blk.device;
+    e->channel = blk.channel;
+    w->offset += sizeof(blk) + payload;
+    p->count = 0;
+    return 0;
+}
+
+struct ads1115_ts_writer *ads1115_ts_create(const char *path, const struct ads1115_ts_header *info) {
+    struct ads1115_ts_writer *w;
+    struct timespec rt, mono;
+    struct iovec iov;
+    int ret;
+
+    if (!info->num_devices || info->num_devices > ADS1115_TS_MAX_DEVICES) {
+        errno = EINVAL;
+        return NULL;
+    }
+    w = calloc(1, sizeof(*w));
+    if (!w)
+        return NULL;
+
+    w->hdr = *info;
+    memcpy(w->hdr.magic, ADS1115_TS_MAGIC, sizeof(w->hdr.magic));
+    w->hdr.version = ADS1115_TS_VERSION;
+    w->hdr.header_size = sizeof(w->hdr);
+    if (!w->hdr.block_samples)
+        w->hdr.block_samples = ADS1115_TS_BLOCK_SAMPLES;
+    w->encoding = ADS1115_TS_ENC_DELTA;
+    w->encoded = malloc(ads1115_codec_bound(w->hdr.block_samples));
+    if (!w->encoded) {
+        free(w);
+        return NULL;
+    }
+    clock_gettime(CLOCK_REALTIME, &rt);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    w->hdr.realtime_offset_ns = (int64_t)(rt.tv_sec - mono.tv_sec) * 1000000000 +
+                                (rt.tv_nsec - mono.tv_nsec);
+
+    w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (w->fd < 0) {
+        free(w->encoded);
+        free(w);
+        return NULL;
+    }
+    iov = (struct iovec){ &w->hdr, sizeof(w->hdr) };
+    ret = ts_write_all(w->fd, &iov, 1, sizeof(w->hdr));
+    if (ret < 0) {
+        close(w->fd);
+        free(w->encoded);
+        free(w);
+        errno = -ret;
+        return NULL;
+    }
+    w->offset = sizeof(w->hdr);
+    return w;
+}
+
+int ads1115_ts_set_encoding(struct ads1115_ts_writer *w, unsigned int encoding) {
+    if (encoding != ADS1115_TS_ENC_RAW && encoding != ADS1115_TS_ENC_DELTA)
+        return -EINVAL;
+    w->encoding = encoding;
+    return 0;
+}
+
+int ads1115_ts_append(struct ads1115_ts_writer *w, unsigned int device,
+                      const struct ads1115_sample *s, size_t n) {
+    struct ts_pending *p;
+    unsigned int stream;
+    size_t i;
+    int ret;
+
+    if (device >= w->hdr.num_devices)
+        return -EINVAL;
+
+    for (i = 0; i < n; i++) {
+        if (s[i].channel >= ADS1115_NUM_CHANNELS)
+            return -EINVAL;
+        stream = device * ADS1115_NUM_CHANNELS + s[i].channel;
+        p = w->pending[stream];
+        if (!p) {
+            p = ts_pending_alloc(w->hdr.block_samples);
+            if (!p)
+                return -ENOMEM;
+            w->pending[stream] = p;
+        }
+        if (p->count && p->generation != s[i].generation) {
+            ret = ts_flush_block(w, stream);
+            if (ret < 0)
+                return ret;
+        }
+        p->generation = s[i].generation;
+        p->timestamp_ns[p->count] = s[i].timestamp_ns;
+        p->value[p->count] = s[i].value;
+        p->seq[p->count] = s[i].seq;
+        p->flags[p->count] = s[i].flags;
+        if (++p->count == w->hdr.block_samples) {
+            ret = ts_flush_block(w, stream);
+            if (ret < 0)
+                return ret;
+        }
+    }
+    return 0;
+}
+
+static int ts_index_cmp(const void *a, const void *b) {
+    const struct ads1115_ts_index_entry *x = a, *y = b;
+
+    if (x->device != y->device)
+        return x->device - y->device;
+    if (x->channel != y->channel)
+        return x->channel - y->channel;
+    return x->first_ns < y->first_ns ? -1 : x->first_ns > y->first_ns;
+}
+
+int ads1115_ts_close(struct ads1115_ts_writer *w) {
+    struct ads1115_ts_footer footer = { .magic = ADS1115_TS_INDEX_MAGIC };
+    struct iovec iov[2];
+    unsigned int i;
+    int ret = 0;
+
+    for (i = 0; i < TS_STREAMS && !ret; i++)
+        ret = ts_flush_block(w, i);
+
+    if (!ret) {
+        qsort(w->index, w->index_entries, sizeof(*w->index), ts_index_cmp);
+        footer.index_offset = w->offset;
+        footer.index_entries = w->index_entries;
+        iov[0] = (struct iovec){ w->index, w->index_entries * sizeof(*w->index) };
+        iov[1] = (struct iovec){ &footer, sizeof(footer) };
+        ret = ts_write_all(w->fd, iov, 2, iov[0].iov_len + sizeof(footer));
+    }
+    if (close(w->fd) < 0 && !ret)
+        ret = -errno;
+
+    for (i = 0; i < TS_STREAMS; i++)
+        ts_pending_free(w->pending[i]);
+    free(w->index);
+    free(w->encoded);
+    free(w);
+    return ret;
+}
+
+// Block at offset if its header and payload lie inside the file
+static const struct ads1115_ts_block *ts_block_at(const struct ads1115_ts_reader *r, uint64_t offset) {
+    const struct ads1115_ts_block *blk;
+
+    if (offset % 8 || offset < r->hdr->header_size || offset + sizeof(*blk) > r->size)
+        return NULL;
+    blk = (const struct ads1115_ts_block *)(r->map + offset);
+    if (blk->magic != ADS1115_TS_BLOCK_MAGIC ||
+        !blk->count || blk->count > r->hdr->block_samples || blk->payload_size % 8 ||
+        (blk->encoding == ADS1115_TS_ENC_RAW && blk->payload_size < ts_raw_size(blk->count)) ||
+        (blk->encoding != ADS1115_TS_ENC_RAW && blk->encoding != ADS1115_TS_ENC_DELTA) ||
+        blk->payload_size > r->size - offset - sizeof(*blk) ||
+        blk->device >= r->hdr->num_devices || blk->channel >= ADS1115_NUM_CHANNELS)
+        return NULL;
+    return blk;
+}
+
+// Walk the blocks of a file its writer never closed
+static int ts_rebuild_index(struct ads1115_ts_reader *r) {
+    const struct ads1115_ts_block *blk;
+    struct ads1115_ts_index_entry *e;
+    uint64_t offset = r->hdr->header_size;
+    size_t alloc = 0;
+
+    while ((blk = ts_block_at(r, offset))) {
+        if (r->index_entries == alloc) {
+            alloc = alloc ? alloc * 2 : 64;
+            e = realloc(r->rebuilt, alloc * sizeof(*e));
+            if (!e)
+                return -ENOMEM;
+            r->rebuilt = e;
+        }
+        e = &r->rebuilt[r->index_entries++];
+        memset(e, 0, sizeof(*e));
+        e->first_ns = blk->first_ns;
+        e->last_ns = blk->last_ns;
+        e->offset = offset;
+        e->count = blk->count;
+        e->device = blk->device;
+        e->channel = blk->channel;
+        offset += sizeof(*blk) + blk->payload_size;
+    }
+    if (r->index_entries)
+        qsort(r->rebuilt, r->index_entries, sizeof(*r->rebuilt), ts_index_cmp);
+    r->index = r->rebuilt;
+    return 0;
+}
+
+static int ts_load_index(struct ads1115_ts_reader *r) {
+    const struct ads1115_ts_footer *footer;
+    size_t i;
+
+    if (r->size < r->hdr->header_size + sizeof(*footer))
+        return ts_rebuild_index(r);
+    footer = (const struct ads1115_ts_footer *)(r->map + r->size - sizeof(*footer));
+    if (footer->magic != ADS1115_TS_INDEX_MAGIC || footer->index_offset % 8 ||
+        footer->index_offset < r->hdr->header_size ||
+        footer->index_offset + (uint64_t)footer->index_entries * sizeof(*r->index) !=
+        r->size - sizeof(*footer))
+        return ts_rebuild_index(r);
+
+    r->index = (const struct ads1115_ts_index_entry *)(r->map + footer->index_offset);
+    r->index_entries = footer->index_entries;
+    for (i = 0; i < r->index_entries; i++)
+        if (!ts_block_at(r, r->index[i].offset))
+            return -EBADMSG;
+    return 0;
+}
+
+struct ads1115_ts_reader *ads1115_ts_open(const char *path) {
+    struct ads1115_ts_reader *r;
+    struct stat st;
+    void *map;
+    int fd, ret;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &st) < 0) {
+        ret = -errno;
+        goto err_close;
+    }
+    ret = -EBADMSG;
+    if ((size_t)st.st_size < sizeof(struct ads1115_ts_header))
+        goto err_close;
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        ret = -errno;
+        goto err_close;
+    }
+    close(fd);
+
+    r = calloc(1, sizeof(*r));
+    if (!r) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    r->map = map;
+    r->size = st.st_size;
+    r->hdr = map;
+    ret = -EBADMSG;
+    if (memcmp(r->hdr->magic, ADS1115_TS_MAGIC, sizeof(r->hdr->magic)) ||
+        r->hdr->version != ADS1115_TS_VERSION || r->hdr->header_size < sizeof(*r->hdr) ||
+        r->hdr->header_size % 8 || r->hdr->header_size > r->size ||
+        !r->hdr->num_devices || r->hdr->num_devices > ADS1115_TS_MAX_DEVICES)
+        goto err_release;
+    ret = ts_load_index(r);
+    if (ret < 0)
+        goto err_release;
+    return r;
+
+err_release:
+    ads1115_ts_release(r);
+    errno = -ret;
+    return NULL;
+err_close:
+    close(fd);
+    errno = -ret;
+    return NULL;
+}
+
+void ads1115_ts_release(struct ads1115_ts_reader *r) {
+    if (!r)
+        return;
+    munmap((void *)r->map, r->size);
+    free(r->rebuilt);
+    free(r->timestamp_ns);
+    free(r->value);
+    free(r->seq);
+    free(r->flags);
+    free(r);
+}
+
+const struct ads1115_ts_header *ads1115_ts_info(const struct ads1115_ts_reader *r) {
+    return r->hdr;
+}
+
+const struct ads1115_ts_index_entry *ads1115_ts_index(const struct ads1115_ts_reader *r, size_t *entries) {
+    *entries = r->index_entries;
+    return r->index;
+}
+
+int ads1115_ts_seek(const struct ads1115_ts_reader *r, unsigned int device, unsigned int channel,
+                    uint64_t from_ns, uint64_t to_ns, struct ads1115_ts_cursor *cur) {
+    const struct ads1115_ts_index_entry *idx = r->index;
+    size_t lo = 0, hi = r->index_entries, mid, end;
+
+    if (device >= r->hdr->num_devices || channel >= ADS1115_NUM_CHANNELS || from_ns > to_ns)
+        return -EINVAL;
+
+    // First block of the channel
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (idx[mid].device < device || (idx[mid].device == device && idx[mid].channel < channel))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    // Past its last block
+    for (end = lo, hi = r->index_entries; end < hi; ) {
+        mid = end + (hi - end) / 2;
+        if (idx[mid].device == device && idx[mid].channel == channel)
+            end = mid + 1;
+        else
+            hi = mid;
+    }
+    // First block that ends at or after from_ns; blocks of a channel do not overlap
+    for (hi = end; lo < hi; ) {
+        mid = lo + (hi - lo) / 2;
+        if (idx[mid].last_ns < from_ns)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    memset(cur, 0, sizeof(*cur));
+    cur->next = idx + lo;
+    cur->end = idx + end;
+    cur->from_ns = from_ns;
+    cur->to_ns = to_ns;
+    return 0;
+}
+
+// Columns of a block, decoding a compressed one into the reader's buffers
+static int ts_block_columns(struct ads1115_ts_reader *r, const struct ads1115_ts_block *blk,
+                            struct ts_columns *cols) {
+    size_t max = r->hdr->block_samples;
+    int ret;
+
+    if (blk->encoding == ADS1115_TS_ENC_RAW) {
+        cols->timestamp_ns = (const uint64_t *)(blk + 1);
+        cols->value = (const int16_t *)(cols->timestamp_ns + blk->count);
+        cols->seq = (const uint16_t *)(cols->value + blk->count);
+        cols->flags = (const uint8_t *)(cols->seq + blk->count);
+        return 0;
+    }
+
+    if (!r->timestamp_ns) {
+        r->timestamp_ns = malloc(max * sizeof(*r->timestamp_ns));
+        r->value = malloc(max * sizeof(*r->value));
+        r->seq = malloc(max * sizeof(*r->seq));
+        r->flags = malloc(max * sizeof(*r->flags));
+        if (!r->timestamp_ns || !r->value || !r->seq || !r->flags) {
+            free(r->timestamp_ns);
+            free(r->value);
+            free(r->seq);
+            free(r->flags);
+            r->timestamp_ns = NULL;
+            return -ENOMEM;
+        }
+    }
+    if (r->decoded != blk) {
+        r->decoded = NULL;
+        ret = ads1115_codec_decode((const uint8_t *)(blk + 1), blk->payload_size, blk->count,
+                                   blk->first_ns, r->timestamp_ns, r->value, r->seq, r->flags);
+        if (ret < 0)
+            return ret;
+        r->decoded = blk;
+    }
+    cols->timestamp_ns = r->timestamp_ns;
+    cols->value = r->value;
+    cols->seq = r->seq;
+    cols->flags = r->flags;
+    return 0;
+}
+
+ssize_t ads1115_ts_read(struct ads1115_ts_reader *r, struct ads1115_ts_cursor *cur,
+                        struct ads1115_sample *buf, size_t count) {
+    struct ts_columns cols;
+    size_t n = 0;
+    uint32_t lo, hi, mid;
+    int ret;
+
+    while (n < count) {
+        if (!cur->block) {
+            if (cur->next == cur->end || cur->next->first_ns > cur->to_ns)
+                break;
+            cur->block = (const struct ads1115_ts_block *)(r->map + cur->next->offset);
+            cur->next++;
+            ret = ts_block_columns(r, cur->block, &cols);
+            if (ret < 0) {
+                cur->block = NULL;
+                return n ? (ssize_t)n : ret;
+            }
+            // First sample at or after from_ns, only the first block can start earlier
+            for (lo = 0, hi = cur->block->count; lo < hi; ) {
+                mid = lo + (hi - lo) / 2;
+                if (cols.timestamp_ns[mid] < cur->from_ns)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            cur->pos = lo;
+        } else {
+            ret = ts_block_columns(r, cur->block, &cols);
+            if (ret < 0)
+                return n ? (ssize_t)n : ret;
+        }
+
+        while (n < count && cur->pos < cur->block->count) {
+            if (cols.timestamp_ns[cur->pos] > cur->to_ns) {
+                cur->next = cur->end; // Past the range
+                cur->block = NULL;
+                return n;
+            }
+            buf[n].timestamp_ns = cols.timestamp_ns[cur->pos];
+            buf[n].value = cols.value[cur->pos];
+            buf[n].channel = cur->block->channel;
+            buf[n].flags = cols.flags[cur->pos];
+            buf[n].seq = cols.seq[cur->pos];
+            buf[n].generation = cur->block->generation;
+            cur->pos++;
+            n++;
+        }
+        if (cur->pos == cur->block->count)
+            cur->block = NULL;
+    }
+    return n;
+}
@@ -0,0 +1,139 @@
+#ifndef ADS1115_TSFILE_H
+#define ADS1115_TSFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "ads1115_lib.h"
+
+// Block-based time-series files for recorded sample streams. Samples are
+// grouped per (device, channel) into blocks of up to block_samples, each
+// with its own header carrying the time span, count and stream generation
+// (a reconfig starts a new block). A sparse index at the tail, one entry per
+// block sorted by device, channel and time, lets a reader find the blocks of
+// one channel in a time range with two binary searches and touch only those
+// pages of the mapped file.
+//
+// Layout, host byte order, every part 8-byte aligned:
+//   struct ads1115_ts_header
+//   blocks: struct ads1115_ts_block, then the encoded payload
+//   struct ads1115_ts_index_entry[index_entries]
+//   struct ads1115_ts_footer
+// A file whose writer died has no index; the reader rebuilds it by walking
+// the block headers, dropping a torn last block.
+
+#define ADS1115_TS_MAGIC          "ADS1115T"
+#define ADS1115_TS_VERSION        2 // 2: generation in the block header
+#define ADS1115_TS_MAX_DEVICES    8
+#define ADS1115_TS_BLOCK_SAMPLES  4096       // Default samples per block
+#define ADS1115_TS_BLOCK_MAGIC    0x4b4c4254 // "TBLK"
+#define ADS1115_TS_INDEX_MAGIC    0x58444954 // "TIDX"
+#define ADS1115_TS_PGA_UNKNOWN    0xff       // Gain not known to the writer
+
+// Raw payload: uint64_t timestamp_ns[count], int16_t value[count],
+// uint16_t seq[count], uint8_t flags[count], zero padded to 8 bytes
+#define ADS1115_TS_ENC_RAW        0
+// Delta/zigzag bit-packed columns (ads1115_codec.h), zero padded to 8 bytes
+#define ADS1115_TS_ENC_DELTA      1
+
+// Acquisition settings of one recorded device
+struct ads1115_ts_device {
+    uint32_t channel_mask;  // Channels recorded
+    uint8_t data_rate;      // DR code
+    uint8_t pga[ADS1115_NUM_CHANNELS]; // PGA code per channel or ADS1115_TS_PGA_UNKNOWN
+    uint8_t reserved[3];
+};
+
+struct ads1115_ts_header {
+    char magic[8];               // ADS1115_TS_MAGIC, not NUL-terminated
+    uint32_t version;            // ADS1115_TS_VERSION
+    uint32_t header_size;        // Offset of the first block
+    int64_t realtime_offset_ns;  // CLOCK_REALTIME minus CLOCK_MONOTONIC when created
+    uint32_t block_samples;      // Most samples in one block
+    uint32_t num_devices;
+    struct ads1115_ts_device devices[ADS1115_TS_MAX_DEVICES];
+};
+
+struct ads1115_ts_block {
+    uint32_t magic;         // ADS1115_TS_BLOCK_MAGIC
+    uint8_t device;
+    uint8_t channel;
+    uint8_t encoding;       // ADS1115_TS_ENC_*
+    uint8_t reserved;
+    uint32_t count;         // Samples in the block
+    uint32_t payload_size;  // Bytes after this header, padding included
+    uint16_t generation;    // Stream generation of every sample in the block
+    uint8_t reserved2[6];
+    uint64_t first_ns;      // Timestamp of the first sample
+    uint64_t last_ns;       // Timestamp of the last sample
+};
+
+struct ads1115_ts_index_entry {
+    uint64_t first_ns;
+    uint64_t last_ns;
+    uint64_t offset;        // File offset of the struct ads1115_ts_block
+    uint32_t count;
+    uint8_t device;
+    uint8_t channel;
+    uint16_t reserved;
+};
+
+struct ads1115_ts_footer {
+    uint64_t index_offset;
+    uint32_t index_entries;
+    uint32_t magic;         // ADS1115_TS_INDEX_MAGIC
+};
+
+struct ads1115_ts_writer;
+struct ads1115_ts_reader;
+
+// Create path for writing. info supplies num_devices, devices[] and
+// block_samples (0 for ADS1115_TS_BLOCK_SAMPLES); the rest is filled in.
+// Returns NULL with errno set on failure.
+struct ads1115_ts_writer *ads1115_ts_create(const char *path, const struct ads1115_ts_header *info);
+
+// Encoding of the blocks written from now on, ADS1115_TS_ENC_DELTA by default
+int ads1115_ts_set_encoding(struct ads1115_ts_writer *w, unsigned int encoding);
+
+// Append samples of one device. Timestamps must not go backwards within a
+// channel; full blocks are written as they fill, and a channel's block is
+// written early when the generation of its samples changes.
+int ads1115_ts_append(struct ads1115_ts_writer *w, unsigned int device,
+                      const struct ads1115_sample *s, size_t n);
+
+// Write the partial blocks, the index and the footer, then close. The
+// writer is freed even on failure.
+int ads1115_ts_close(struct ads1115_ts_writer *w);
+
+// Map path for reading. Returns NULL with errno set on failure.
+struct ads1115_ts_reader *ads1115_ts_open(const char *path);
+void ads1115_ts_release(struct ads1115_ts_reader *r);
+
+const struct ads1115_ts_header *ads1115_ts_info(const struct ads1115_ts_reader *r);
+
+// Index entries, sorted by device, channel and first_ns
+const struct ads1115_ts_index_entry *ads1115_ts_index(const struct ads1115_ts_reader *r, size_t *entries);
+
+// Position of a range query, filled by ads1115_ts_seek()
+struct ads1115_ts_cursor {
+    const struct ads1115_ts_index_entry *next; // Next block to visit
+    const struct ads1115_ts_index_entry *end;
+    const struct ads1115_ts_block *block;      // Block being read, NULL between blocks
+    uint32_t pos;                              // Next sample in block
+    uint64_t from_ns;
+    uint64_t to_ns;
+};
+
+// Start a query for the samples of one channel with from_ns <= timestamp <= to_ns
+int ads1115_ts_seek(const struct ads1115_ts_reader *r, unsigned int device, unsigned int channel,
+                    uint64_t from_ns, uint64_t to_ns, struct ads1115_ts_cursor *cur);
+
+// Next samples of the query in time order, 0 at the end, -EBADMSG for a
+// block that does not decode. Compressed blocks are
+// decoded into a buffer of the reader, so cursors of one reader must not
+// be read from several threads at once.
+ssize_t ads1115_ts_read(struct ads1115_ts_reader *r, struct ads1115_ts_cursor *cur,
+                        struct ads1115_sample *buf, size_t count);
+
+#endif
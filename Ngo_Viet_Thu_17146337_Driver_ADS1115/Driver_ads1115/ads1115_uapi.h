@@ -0,0 +1,104 @@
+#ifndef ADS1115_UAPI_H
+#define ADS1115_UAPI_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+// Interface between ads1115_driver.c and userspace, shared by the driver,
+// libads1115 and the tools. Every struct uses fixed-size fields, explicit
+// padding and 64-bit aligned u64s, so 32-bit processes on 64-bit kernels
+// see the same layout and the driver's compat_ioctl passes them straight
+// through. Changing a layout or an ioctl number bumps ADS1115_UAPI_VERSION.
+
+#define ADS1115_UAPI_VERSION 1 // Reported by ADS1115_IOCTL_GET_VERSION
+
+// Stream configuration passed to ADS1115_IOCTL_STREAM_START
+struct ads1115_stream_config {
+    __u32 channel_mask; // Bit n enables AINn
+    __u32 data_rate;    // DR code 0..7 (8..860 samples/second)
+};
+
+// One record returned by read() on a streaming device
+struct ads1115_sample {
+    __aligned_u64 timestamp_ns; // CLOCK_MONOTONIC time the result was read
+    __s16 value;        // Raw conversion result
+    __u8  channel;      // AIN index
+    __u8  flags;        // ADS1115_SAMPLE_* bits
+    __u16 seq;          // Per-stream sequence number, gaps mean dropped samples
+    __u16 generation;   // Stream config in effect, 0 at start, bumped by each reconfig, wraps
+};
+
+// New config for a running stream, passed to ADS1115_IOCTL_STREAM_RECONFIG.
+// The sampler switches at the next conversion boundary; generation returns
+// the tag carried by the samples taken with it. Generations are 16 bits and
+// wrap after 65535 reconfigs of one stream back to 0, so a tag identifies a
+// config only among the last 65536; a reader that lets samples sit in the
+// ring across that many reconfigs cannot tell an old generation from a new
+// one. Stream start resets the count to 0.
+struct ads1115_stream_reconfig {
+    __u32 channel_mask; // Bit n enables AINn
+    __u32 data_rate;    // DR code 0..7
+    __u8  pga[4];       // PGA code per channel AIN0..AIN3, ADS1115_PGA_KEEP leaves it unchanged
+    __u16 generation;   // Out: generation tag of the new config
+    __u16 reserved;     // Must be zero
+};
+
+#define ADS1115_PGA_KEEP 0xff // Leave the channel's gain unchanged
+
+#define ADS1115_OVER_RANGE_MARGIN_UV 300000 // Inputs may swing 0.3 V past VDD before over-range
+
+// Stream buffer of one open file, passed to ADS1115_IOCTL_SET_BUFFER
+struct ads1115_buffer_config {
+    __u32 ring_size; // Ring slots, power of two, 0 keeps the current size
+    __u32 watermark; // Samples buffered before read() and poll() wake up
+};
+
+// ads1115_sample.flags
+#define ADS1115_SAMPLE_GAP          0x01 // First sample after a bus recovery, time has a hole before it
+#define ADS1115_SAMPLE_SAT_HIGH     0x02 // Positive full-scale code, the input may be higher
+#define ADS1115_SAMPLE_SAT_LOW      0x04 // Negative full-scale code, the input may be lower
+#define ADS1115_SAMPLE_OVER_RANGE   0x08 // Input at or beyond VDD + ADS1115_OVER_RANGE_MARGIN_UV,
+                                         // the absolute-maximum pin voltage
+#define ADS1115_SAMPLE_GAIN_CHANGED 0x10 // PGA differs from this channel's previous sample
+#define ADS1115_SAMPLE_MUX_SWITCH   0x20 // First conversion after the MUX moved to this input
+#define ADS1115_SAMPLE_INTERPOLATED 0x40 // Reserved: never set by the driver or libads1115, free for
+                                         // consumers to mark samples they synthesise
+
+// IOCTL commands
+#define ADS1115_IOCTL_MAGIC 'a' // IOCTL magic character
+#define ADS1115_IOCTL_READ_AIN(ch) _IOR(ADS1115_IOCTL_MAGIC, (ch), __s16) // Read AINch, ch 0..3
+#define ADS1115_IOCTL_READ_AIN0 ADS1115_IOCTL_READ_AIN(0) // Read AIN0
+#define ADS1115_IOCTL_READ_AIN1 ADS1115_IOCTL_READ_AIN(1) // Read AIN1
+#define ADS1115_IOCTL_READ_AIN2 ADS1115_IOCTL_READ_AIN(2) // Read AIN2
+#define ADS1115_IOCTL_READ_AIN3 ADS1115_IOCTL_READ_AIN(3) // Read AIN3
+#define ADS1115_IOCTL_STREAM_START _IOW(ADS1115_IOCTL_MAGIC, 4, struct ads1115_stream_config) // Start sampler
+#define ADS1115_IOCTL_STREAM_STOP  _IO(ADS1115_IOCTL_MAGIC, 5) // Stop sampler
+#define ADS1115_IOCTL_STREAM_RECONFIG _IOWR(ADS1115_IOCTL_MAGIC, 6, struct ads1115_stream_reconfig) // Stage a new stream config
+#define ADS1115_IOCTL_SET_BUFFER   _IOW(ADS1115_IOCTL_MAGIC, 7, struct ads1115_buffer_config) // Ring size and watermark
+#define ADS1115_IOCTL_GET_VERSION  _IOR(ADS1115_IOCTL_MAGIC, 8, __u32) // ADS1115_UAPI_VERSION of the driver
+
+// ABI check. Any compiler that includes this header, whatever its word
+// size, fails here if a layout drifts from the one the driver was built with.
+// Equal sizes also give equal ioctl numbers, which compat_ptr_ioctl relies on.
+// make uapi-check runs these for -m32 and -mx32.
+#define ADS1115_UAPI_LAYOUT(type, size) \
+    _Static_assert(sizeof(struct type) == (size), #type " size differs between ABIs")
+#define ADS1115_UAPI_OFFSET(type, field, off) \
+    _Static_assert(__builtin_offsetof(struct type, field) == (off), #type "." #field " offset differs between ABIs")
+
+ADS1115_UAPI_LAYOUT(ads1115_stream_config, 8);
+ADS1115_UAPI_OFFSET(ads1115_stream_config, data_rate, 4);
+ADS1115_UAPI_LAYOUT(ads1115_sample, 16);
+ADS1115_UAPI_OFFSET(ads1115_sample, value, 8);
+ADS1115_UAPI_OFFSET(ads1115_sample, channel, 10);
+ADS1115_UAPI_OFFSET(ads1115_sample, flags, 11);
+ADS1115_UAPI_OFFSET(ads1115_sample, seq, 12);
+ADS1115_UAPI_OFFSET(ads1115_sample, generation, 14);
+ADS1115_UAPI_LAYOUT(ads1115_stream_reconfig, 16);
+ADS1115_UAPI_OFFSET(ads1115_stream_reconfig, pga, 8);
+ADS1115_UAPI_OFFSET(ads1115_stream_reconfig, generation, 12);
+ADS1115_UAPI_LAYOUT(ads1115_buffer_config, 8);
+ADS1115_UAPI_OFFSET(ads1115_buffer_config, watermark, 4);
+_Static_assert(__alignof__(struct ads1115_sample) == 8, "ads1115_sample alignment differs between ABIs");
+
+#endif // ADS1115_UAPI_H
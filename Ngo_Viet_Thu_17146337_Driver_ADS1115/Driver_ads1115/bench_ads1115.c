@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "ads1115_lib.h"
+#include "ads1115_bench.h"
+#include "ads1115_model.h"
+
+// Latency and throughput benchmark for every access mode of the client API.
+// Runs against the kernel driver, a chip on /dev/i2c-N or an in-process
+// software chip, and prints one JSON object per mode.
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s (-d chrdev | -b i2c_bus [-a addr] | -M) [options]\n"
+            "  -m modes       Comma-separated list of single,scan,burst,stream (default all)\n"
+            "  -c mask        Channel mask (default 0xf)\n"
+            "  -r rate        DR code 0..7 for burst and stream (default 7)\n"
+            "  -n samples     Samples per mode (default 1000)\n"
+            "  -B length      Samples per burst (default 32)\n"
+            "  -o file        Write JSON results to file (default stdout)\n", prog);
+}
+
+// Channel-distinct levels so a mixed-up channel shows in the values
+static void setup_model(struct ads1115_model *model) {
+    int i;
+
+    ads1115_model_init(model, 1);
+    for (i = 0; i < ADS1115_MODEL_NUM_INPUTS; i++) {
+        model->signals[i].offset_uv = (i + 1) * 500000;
+        model->signals[i].noise_uv = 200;
+    }
+}
+
+int main(int argc, char **argv) {
+    struct ads1115_bench_params p = { .channel_mask = 0xF, .data_rate = ADS1115_DR_MAX,
+                                      .samples = 1000, .burst_len = 32 };
+    struct ads1115_bench_result r;
+    struct ads1115_model model;
+    struct ads1115_dev *dev;
+    const char *chrdev = NULL, *modes = "single,scan,burst,stream";
+    char *list, *tok, *save;
+    FILE *out = stdout;
+    int bus = -1, addr = 0x48, use_model = 0, mode, opt, ret, failed = 0;
+
+    while ((opt = getopt(argc, argv, "d:b:a:Mm:c:r:n:B:o:h")) != -1) {
+        switch (opt) {
+        case 'd': chrdev = optarg; break;
+        case 'b': bus = atoi(optarg); break;
+        case 'a': addr = strtol(optarg, NULL, 0); break;
+        case 'M': use_model = 1; break;
+        case 'm': modes = optarg; break;
+        case 'c': p.channel_mask = strtoul(optarg, NULL, 0); break;
+        case 'r': p.data_rate = strtoul(optarg, NULL, 0); break;
+        case 'n': p.samples = strtoul(optarg, NULL, 0); break;
+        case 'B': p.burst_len = strtoul(optarg, NULL, 0); break;
+        case 'o':
+            out = fopen(optarg, "w");
+            if (!out) {
+                perror("Failed to open the output file");
+                return errno;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (chrdev) {
+        dev = ads1115_open_chrdev(chrdev);
+    } else if (bus >= 0) {
+        dev = ads1115_open_i2cdev(bus, addr);
+    } else if (use_model) {
+        setup_model(&model);
+        dev = ads1115_open_model(&model, NULL);
+    } else {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (!dev) {
+        perror("Failed to open the device");
+        return errno;
+    }
+
+    list = strdup(modes);
+    for (tok = strtok_r(list, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        mode = ads1115_bench_mode_parse(tok);
+        if (mode < 0) {
+            fprintf(stderr, "Unknown mode: %s\n", tok);
+            failed = 1;
+            continue;
+        }
+        p.mode = mode;
+        ret = ads1115_bench_run(dev, &p, &r);
+        if (ret < 0) {
+            fprintf(stderr, "%s: %s\n", tok, strerror(-ret));
+            failed = 1;
+            continue;
+        }
+        ads1115_bench_print_json(out, dev, &p, &r);
+        fflush(out);
+    }
+
+    free(list);
+    ads1115_close(dev);
+    if (out != stdout)
+        fclose(out);
+    return failed ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/resource.h>
+
+#include "ads1115_lib.h"
+
+// Compare the kernel driver and the i2c-dev backend on the same workload:
+// per-call latency and CPU time per sample for single reads and scans.
+
+struct workload {
+    const char *name;
+    uint32_t channel_mask; // 0 means single reads of one channel
+};
+
+static const struct workload workloads[] = {
+    { "single", 0 },
+    { "scan4", 0xF },
+};
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static double tv_us(struct timeval tv) {
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+static int run(struct ads1115_dev *dev, const struct workload *w, unsigned int channel, int iters) {
+    uint64_t *lat = calloc(iters, sizeof(*lat));
+    int16_t values[ADS1115_NUM_CHANNELS];
+    struct rusage ru0, ru1;
+    uint64_t t0, sum = 0;
+    double cpu_us;
+    int i, ret = 0, per_iter;
+
+    if (!lat)
+        return -ENOMEM;
+
+    per_iter = w->channel_mask ? __builtin_popcount(w->channel_mask) : 1;
+    getrusage(RUSAGE_SELF, &ru0);
+    for (i = 0; i < iters; i++) {
+        t0 = ads1115_now_ns();
+        if (w->channel_mask)
+            ret = ads1115_scan(dev, w->channel_mask, values);
+        else
+            ret = ads1115_read_channel(dev, channel, &values[0]);
+        lat[i] = ads1115_now_ns() - t0;
+        if (ret < 0)
+            break;
+        sum += lat[i];
+    }
+    getrusage(RUSAGE_SELF, &ru1);
+
+    if (ret < 0) {
+        fprintf(stderr, "%s %s: %s\n", ads1115_backend_name(dev), w->name, strerror(-ret));
+        free(lat);
+        return ret;
+    }
+
+    qsort(lat, iters, sizeof(*lat), cmp_u64);
+    cpu_us = tv_us(ru1.ru_utime) - tv_us(ru0.ru_utime) + tv_us(ru1.ru_stime) - tv_us(ru0.ru_stime);
+    printf("%-7s %-7s mean=%8.1fus p50=%8.1fus p99=%8.1fus max=%8.1fus cpu/sample=%6.2fus csw=%ld\n",
+           ads1115_backend_name(dev), w->name, sum / 1e3 / iters,
+           lat[iters / 2] / 1e3, lat[(size_t)iters * 99 / 100] / 1e3, lat[iters - 1] / 1e3,
+           cpu_us / ((double)iters * per_iter),
+           (ru1.ru_nvcsw - ru0.ru_nvcsw) + (ru1.ru_nivcsw - ru0.ru_nivcsw));
+    free(lat);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-d chrdev] [-b i2c_bus] [-a addr] [-n iterations] [-c channel]\n"
+                    "Runs the chrdev path if -d is given and the i2c-dev path if -b is given.\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *chrdev = NULL;
+    struct ads1115_dev *devs[2];
+    int bus = -1, addr = 0x48, iters = 200, ndev = 0;
+    unsigned int channel = 0;
+    size_t i;
+    int d, opt;
+
+    while ((opt = getopt(argc, argv, "d:b:a:n:c:h")) != -1) {
+        switch (opt) {
+        case 'd': chrdev = optarg; break;
+        case 'b': bus = atoi(optarg); break;
+        case 'a': addr = strtol(optarg, NULL, 0); break;
+        case 'n': iters = atoi(optarg); break;
+        case 'c': channel = atoi(optarg); break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((!chrdev && bus < 0) || iters <= 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (chrdev) {
+        devs[ndev] = ads1115_open_chrdev(chrdev);
+        if (!devs[ndev]) {
+            perror("Failed to open the device");
+            return errno;
+        }
+        ndev++;
+    }
+    if (bus >= 0) {
+        devs[ndev] = ads1115_open_i2cdev(bus, addr);
+        if (!devs[ndev]) {
+            perror("Failed to open the I2C bus");
+            return errno;
+        }
+        ndev++;
+    }
+
+    for (i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++)
+        for (d = 0; d < ndev; d++)
+            run(devs[d], &workloads[i], channel, iters);
+
+    for (d = 0; d < ndev; d++)
+        ads1115_close(devs[d]);
+    return 0;
+}
@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "ads1115_lib.h"
+#include "ads1115_model.h"
+#include "ads1115_tsfile.h"
+#include "ads1115_codec.h"
+
+// Compression ratio and speed of the block codec (ads1115_codec.h). Works on
+// a recording (-i, any ads1115_tsfile.h file, e.g. from acquire_ads1115 on
+// real hardware) or on a stream from a software chip with sine, noise, ramp
+// and square inputs and scheduling jitter added to the timestamps. Samples
+// are cut into per-channel blocks, encoded and decoded repeatedly with the
+// scalar and the SIMD decoder, and every decode is checked against the input.
+
+#define BENCH_RAW_BYTES  13 // Raw tsfile bytes per sample: timestamp, value, seq, flags
+#define BENCH_CSV_BYTES  32 // Typical acquire_ads1115 CSV line
+
+// Samples of one channel in columns
+struct channel_data {
+    uint64_t *timestamp_ns;
+    int16_t *value;
+    uint16_t *seq;
+    uint8_t *flags;
+    size_t count;
+    size_t alloc;
+};
+
+struct codec_result {
+    size_t samples;
+    size_t blocks;
+    size_t encoded_bytes;
+    double encode_msps;
+    double decode_msps[2]; // Scalar, SIMD
+    int mismatches;
+};
+
+static unsigned long long jitter_rng = 0x9e3779b97f4a7c15ull;
+
+static unsigned long long next_rng(void) {
+    jitter_rng ^= jitter_rng << 13;
+    jitter_rng ^= jitter_rng >> 7;
+    jitter_rng ^= jitter_rng << 17;
+    return jitter_rng;
+}
+
+static int channel_push(struct channel_data *c, const struct ads1115_sample *s) {
+    size_t alloc;
+
+    if (c->count == c->alloc) {
+        alloc = c->alloc ? c->alloc * 2 : 4096;
+        if (!(c->timestamp_ns = realloc(c->timestamp_ns, alloc * sizeof(*c->timestamp_ns))) ||
+            !(c->value = realloc(c->value, alloc * sizeof(*c->value))) ||
+            !(c->seq = realloc(c->seq, alloc * sizeof(*c->seq))) ||
+            !(c->flags = realloc(c->flags, alloc * sizeof(*c->flags))))
+            return -ENOMEM;
+        c->alloc = alloc;
+    }
+    c->timestamp_ns[c->count] = s->timestamp_ns;
+    c->value[c->count] = s->value;
+    c->seq[c->count] = s->seq;
+    c->flags[c->count] = s->flags;
+    c->count++;
+    return 0;
+}
+
+// Every (device, channel) of a recording becomes one channel_data
+static int load_recording(const char *path, struct channel_data *chans, size_t *num_chans) {
+    const struct ads1115_ts_index_entry *idx;
+    struct ads1115_sample buf[1024];
+    struct ads1115_ts_cursor cur;
+    struct ads1115_ts_reader *r;
+    size_t entries, i;
+    ssize_t n, k;
+    int ret = 0;
+
+    r = ads1115_ts_open(path);
+    if (!r)
+        return -errno;
+    idx = ads1115_ts_index(r, &entries);
+    *num_chans = 0;
+    for (i = 0; i < entries && !ret; i++) {
+        if (i && idx[i].device == idx[i - 1].device && idx[i].channel == idx[i - 1].channel)
+            continue;
+        ret = ads1115_ts_seek(r, idx[i].device, idx[i].channel, 0, UINT64_MAX, &cur);
+        while (!ret && (n = ads1115_ts_read(r, &cur, buf, 1024)) > 0)
+            for (k = 0; k < n && !ret; k++)
+                ret = channel_push(&chans[*num_chans], &buf[k]);
+        (*num_chans)++;
+    }
+    ads1115_ts_release(r);
+    return ret;
+}
+
+// Four channels from a software chip on a virtual clock, timestamps moved
+// by up to +/-jitter_ns as a reader thread's wakeups would
+static int synthesize(size_t per_channel, unsigned int data_rate, unsigned int jitter_ns,
+                      struct channel_data *chans) {
+    struct ads1115_stream_config cfg = { .channel_mask = 0xf, .data_rate = data_rate };
+    struct ads1115_vclock vclock = { .now_ns = 1000000000ull };
+    struct ads1115_sample buf[ADS1115_NUM_CHANNELS];
+    struct ads1115_model model;
+    struct ads1115_dev *dev;
+    ssize_t n, k;
+    int ret = 0;
+
+    ads1115_model_init(&model, 1);
+    model.signals[0] = (struct ads1115_model_signal){ ADS1115_SIGNAL_SINE, 1500000, 1000000, 1000000, 300 };
+    model.signals[1] = (struct ads1115_model_signal){ ADS1115_SIGNAL_CONST, 2500000, 0, 0, 200 };
+    model.signals[2] = (struct ads1115_model_signal){ ADS1115_SIGNAL_RAMP, 200000, 3000000, 5000000, 100 };
+    model.signals[3] = (struct ads1115_model_signal){ ADS1115_SIGNAL_SQUARE, 1000000, 500000, 250000, 50 };
+    dev = ads1115_open_model(&model, &vclock);
+    if (!dev)
+        return -errno;
+    ret = ads1115_stream_start(dev, &cfg);
+    while (!ret && chans[ADS1115_NUM_CHANNELS - 1].count < per_channel) {
+        n = ads1115_stream_read(dev, buf, ADS1115_NUM_CHANNELS);
+        if (n < 0) {
+            ret = n;
+            break;
+        }
+        for (k = 0; k < n && !ret; k++) {
+            if (jitter_ns)
+                buf[k].timestamp_ns += next_rng() % (2 * jitter_ns + 1) - jitter_ns;
+            ret = channel_push(&chans[buf[k].channel], &buf[k]);
+        }
+    }
+    ads1115_close(dev);
+    return ret;
+}
+
+static int run(struct channel_data *chans, size_t num_chans, uint32_t block_samples,
+               unsigned int reps, struct codec_result *r) {
+    size_t bound = ads1115_codec_bound(block_samples), c, off, nblk, b;
+    uint64_t *ts = malloc(block_samples * sizeof(*ts));
+    int16_t *value = malloc(block_samples * sizeof(*value));
+    uint16_t *seq = malloc(block_samples * sizeof(*seq));
+    uint8_t *flags = malloc(block_samples);
+    uint8_t **enc = NULL;
+    size_t *enc_len = NULL;
+    uint32_t *blk_count = NULL;
+    struct channel_data **blk_chan = NULL;
+    size_t *blk_off = NULL;
+    uint64_t t0;
+    unsigned int rep;
+    int simd, ret = -ENOMEM;
+    uint32_t n;
+
+    memset(r, 0, sizeof(*r));
+    for (c = 0, nblk = 0; c < num_chans; c++)
+        nblk += (chans[c].count + block_samples - 1) / block_samples;
+    enc = calloc(nblk, sizeof(*enc));
+    enc_len = calloc(nblk, sizeof(*enc_len));
+    blk_count = calloc(nblk, sizeof(*blk_count));
+    blk_chan = calloc(nblk, sizeof(*blk_chan));
+    blk_off = calloc(nblk, sizeof(*blk_off));
+    if (!ts || !value || !seq || !flags || !enc || !enc_len || !blk_count || !blk_chan || !blk_off)
+        goto out;
+
+    for (c = 0, b = 0; c < num_chans; c++)
+        for (off = 0; off < chans[c].count; off += n, b++) {
+            n = chans[c].count - off < block_samples ? chans[c].count - off : block_samples;
+            blk_chan[b] = &chans[c];
+            blk_off[b] = off;
+            blk_count[b] = n;
+            r->samples += n;
+            if (!(enc[b] = malloc(bound)))
+                goto out;
+        }
+    r->blocks = nblk;
+
+    t0 = ads1115_now_ns();
+    for (rep = 0; rep < reps; rep++)
+        for (b = 0; b < nblk; b++)
+            enc_len[b] = ads1115_codec_encode(blk_chan[b]->timestamp_ns + blk_off[b],
+                                              blk_chan[b]->value + blk_off[b],
+                                              blk_chan[b]->seq + blk_off[b],
+                                              blk_chan[b]->flags + blk_off[b], blk_count[b], enc[b]);
+    r->encode_msps = (double)r->samples * reps / ((ads1115_now_ns() - t0) / 1e3);
+    for (b = 0; b < nblk; b++)
+        r->encoded_bytes += enc_len[b];
+
+    for (simd = 0; simd < 2; simd++) {
+        if (ads1115_codec_use_simd(simd) != simd)
+            continue; // No SIMD decoder for this target
+        t0 = ads1115_now_ns();
+        for (rep = 0; rep < reps; rep++)
+            for (b = 0; b < nblk; b++)
+                if (ads1115_codec_decode(enc[b], enc_len[b], blk_count[b],
+                                         blk_chan[b]->timestamp_ns[blk_off[b]], ts, value, seq, flags) < 0)
+                    r->mismatches++;
+        r->decode_msps[simd] = (double)r->samples * reps / ((ads1115_now_ns() - t0) / 1e3);
+
+        // Outside the timed loop: every block must come back bit-exact
+        for (b = 0; b < nblk; b++) {
+            off = blk_off[b];
+            n = blk_count[b];
+            if (ads1115_codec_decode(enc[b], enc_len[b], n, blk_chan[b]->timestamp_ns[off],
+                                     ts, value, seq, flags) < 0 ||
+                memcmp(ts, blk_chan[b]->timestamp_ns + off, n * sizeof(*ts)) ||
+                memcmp(value, blk_chan[b]->value + off, n * sizeof(*value)) ||
+                memcmp(seq, blk_chan[b]->seq + off, n * sizeof(*seq)) ||
+                memcmp(flags, blk_chan[b]->flags + off, n))
+                r->mismatches++;
+        }
+    }
+    ads1115_codec_use_simd(1);
+    ret = 0;
+out:
+    for (b = 0; enc && b < nblk; b++)
+        free(enc[b]);
+    free(enc);
+    free(enc_len);
+    free(blk_count);
+    free(blk_chan);
+    free(blk_off);
+    free(ts);
+    free(value);
+    free(seq);
+    free(flags);
+    return ret;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-i recording.ts] [options]\n"
+            "  -i file       Recording to compress instead of a software chip\n"
+            "  -n samples    Samples per channel from the software chip (default 200000)\n"
+            "  -r code       DR code of the software chip (default 7)\n"
+            "  -j ns         Timestamp jitter, +/- ns (default 20000)\n"
+            "  -b samples    Block sizes to compare (default 256,1024,4096)\n"
+            "  -R reps       Encode and decode passes timed (default 10)\n", prog);
+}
+
+int main(int argc, char **argv) {
+    struct channel_data chans[ADS1115_TS_MAX_DEVICES * ADS1115_NUM_CHANNELS];
+    const char *input = NULL, *blocks_arg = "256,1024,4096";
+    size_t per_channel = 200000, num_chans = ADS1115_NUM_CHANNELS, c;
+    unsigned int data_rate = ADS1115_DR_MAX, jitter_ns = 20000, reps = 10;
+    struct codec_result r;
+    char *list, *tok, *save;
+    uint32_t block_samples;
+    int opt, ret, failed = 0;
+
+    while ((opt = getopt(argc, argv, "i:n:r:j:b:R:h")) != -1) {
+        switch (opt) {
+        case 'i': input = optarg; break;
+        case 'n': per_channel = strtoul(optarg, NULL, 0); break;
+        case 'r': data_rate = strtoul(optarg, NULL, 0); break;
+        case 'j': jitter_ns = strtoul(optarg, NULL, 0); break;
+        case 'b': blocks_arg = optarg; break;
+        case 'R': reps = strtoul(optarg, NULL, 0); break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!reps || !per_channel || data_rate > ADS1115_DR_MAX) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    memset(chans, 0, sizeof(chans));
+    ret = input ? load_recording(input, chans, &num_chans)
+                : synthesize(per_channel, data_rate, jitter_ns, chans);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to load samples: %s\n", strerror(-ret));
+        return EXIT_FAILURE;
+    }
+
+    printf("%-7s %9s %7s %10s %10s %6s %6s %6s %10s %10s %10s\n", "block", "samples", "blocks",
+           "raw_B", "enc_B", "ratio", "csv_x", "bits", "enc_Msps", "dec_Msps", "simd_Msps");
+    list = strdup(blocks_arg);
+    for (tok = strtok_r(list, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        block_samples = strtoul(tok, NULL, 0);
+        if (!block_samples) {
+            fprintf(stderr, "Invalid block size: %s\n", tok);
+            failed = 1;
+            continue;
+        }
+        ret = run(chans, num_chans, block_samples, reps, &r);
+        if (ret < 0 || !r.samples) {
+            fprintf(stderr, "%u samples per block: %s\n", block_samples, ret < 0 ? strerror(-ret) : "no samples");
+            failed = 1;
+            continue;
+        }
+        printf("%-7u %9zu %7zu %10zu %10zu %6.2f %6.1f %6.2f %10.1f %10.1f %10.1f\n", block_samples,
+               r.samples, r.blocks, r.samples * BENCH_RAW_BYTES, r.encoded_bytes,
+               (double)r.samples * BENCH_RAW_BYTES / r.encoded_bytes,
+               (double)r.samples * BENCH_CSV_BYTES / r.encoded_bytes,
+               r.encoded_bytes * 8.0 / r.samples, r.encode_msps, r.decode_msps[0], r.decode_msps[1]);
+        if (r.mismatches) {
+            fprintf(stderr, "%u samples per block: %d blocks did not decode to the input\n",
+                    block_samples, r.mismatches);
+            failed = 1;
+        }
+        fflush(stdout);
+    }
+    free(list);
+
+    for (c = 0; c < ADS1115_TS_MAX_DEVICES * ADS1115_NUM_CHANNELS; c++) {
+        free(chans[c].timestamp_ns);
+        free(chans[c].value);
+        free(chans[c].seq);
+        free(chans[c].flags);
+    }
+    return failed ? EXIT_FAILURE : 0;
+}
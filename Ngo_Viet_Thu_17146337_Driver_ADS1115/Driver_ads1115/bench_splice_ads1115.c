@@ -0,0 +1,173 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+
+#include "ads1115_uapi.h" // Stream structs and IOCTL commands
+
+#define DEVICE_PATH "/dev/ads1115"
+#define CHUNK_SIZE  (64 * 1024) // Bytes moved per read() or splice()
+
+struct bench_result {
+    size_t bytes;
+    double elapsed_s;
+    double user_s;
+    double sys_s;
+};
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double tv_s(struct timeval tv) {
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// Copy through a userspace buffer: device -> buffer -> file
+static ssize_t move_read_write(int fd, int out, size_t len) {
+    static char buf[CHUNK_SIZE];
+    ssize_t n, done, w;
+
+    n = read(fd, buf, len);
+    for (done = 0; n > 0 && done < n; done += w) {
+        w = write(out, buf + done, n - done);
+        if (w < 0)
+            return -1;
+    }
+    return n;
+}
+
+// Move through a pipe: device -> pipe -> file, no userspace buffer
+static ssize_t move_splice(int fd, int out, size_t len, int pipefd[2]) {
+    ssize_t n, done, w;
+
+    n = splice(fd, NULL, pipefd[1], NULL, len, SPLICE_F_MOVE);
+    for (done = 0; n > 0 && done < n; done += w) {
+        w = splice(pipefd[0], NULL, out, NULL, n - done, SPLICE_F_MOVE);
+        if (w < 0)
+            return -1;
+    }
+    return n;
+}
+
+static int run(const char *out_path, int use_splice, double seconds,
+               const struct ads1115_stream_config *cfg, struct bench_result *res) {
+    struct rusage ru0, ru1;
+    int pipefd[2] = { -1, -1 };
+    int fd, out;
+    double t0, deadline;
+    ssize_t n;
+
+    fd = open(DEVICE_PATH, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open the device");
+        return -1;
+    }
+    out = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        perror("Failed to open the output file");
+        close(fd);
+        return -1;
+    }
+    if (use_splice && pipe(pipefd) < 0) {
+        perror("Failed to create pipe");
+        goto fail;
+    }
+    if (use_splice)
+        fcntl(pipefd[1], F_SETPIPE_SZ, CHUNK_SIZE);
+
+    if (ioctl(fd, ADS1115_IOCTL_STREAM_START, cfg) < 0) {
+        perror("Failed to start stream");
+        goto fail;
+    }
+
+    memset(res, 0, sizeof(*res));
+    getrusage(RUSAGE_SELF, &ru0);
+    t0 = now_s();
+    deadline = t0 + seconds;
+    while (now_s() < deadline) {
+        n = use_splice ? move_splice(fd, out, CHUNK_SIZE, pipefd)
+                       : move_read_write(fd, out, CHUNK_SIZE);
+        if (n < 0) {
+            perror(use_splice ? "splice" : "read/write");
+            break;
+        }
+        if (n == 0)
+            break;
+        res->bytes += n;
+    }
+    res->elapsed_s = now_s() - t0;
+    getrusage(RUSAGE_SELF, &ru1);
+    res->user_s = tv_s(ru1.ru_utime) - tv_s(ru0.ru_utime);
+    res->sys_s = tv_s(ru1.ru_stime) - tv_s(ru0.ru_stime);
+
+    ioctl(fd, ADS1115_IOCTL_STREAM_STOP);
+    if (use_splice) {
+        close(pipefd[0]);
+        close(pipefd[1]);
+    }
+    close(out);
+    close(fd);
+    return 0;
+
+fail:
+    if (pipefd[0] >= 0) {
+        close(pipefd[0]);
+        close(pipefd[1]);
+    }
+    close(out);
+    close(fd);
+    return -1;
+}
+
+static void report(const char *name, const struct bench_result *r) {
+    size_t samples = r->bytes / sizeof(struct ads1115_sample);
+    double cpu = r->user_s + r->sys_s;
+
+    printf("%-10s samples=%zu rate=%.1f/s throughput=%.1f KiB/s cpu=%.3fs (user %.3f sys %.3f) "
+           "cpu/sample=%.2fus\n",
+           name, samples, samples / r->elapsed_s, r->bytes / r->elapsed_s / 1024.0,
+           cpu, r->user_s, r->sys_s, samples ? cpu * 1e6 / samples : 0.0);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-o output] [-t seconds] [-m channel_mask] [-r data_rate_code]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    struct ads1115_stream_config cfg = { .channel_mask = 0x1, .data_rate = 7 };
+    struct bench_result rw, sp;
+    const char *out_path = "/dev/null";
+    double seconds = 10.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:t:m:r:h")) != -1) {
+        switch (opt) {
+        case 'o': out_path = optarg; break;
+        case 't': seconds = atof(optarg); break;
+        case 'm': cfg.channel_mask = strtoul(optarg, NULL, 0); break;
+        case 'r': cfg.data_rate = strtoul(optarg, NULL, 0); break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (run(out_path, 0, seconds, &cfg, &rw) < 0)
+        return errno ? errno : EXIT_FAILURE;
+    if (run(out_path, 1, seconds, &cfg, &sp) < 0)
+        return errno ? errno : EXIT_FAILURE;
+
+    report("read+write", &rw);
+    report("splice", &sp);
+    return 0;
+}
@@ -3,25 +3,21 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <stdint.h>
 #include <errno.h>
 
-// IOCTL commands
-#define ADS1115_IOCTL_MAGIC 'a'
-#define ADS1115_IOCTL_READ_AIN0 _IOR(ADS1115_IOCTL_MAGIC, 0, short)
-#define ADS1115_IOCTL_READ_AIN1 _IOR(ADS1115_IOCTL_MAGIC, 1, short)
-#define ADS1115_IOCTL_READ_AIN2 _IOR(ADS1115_IOCTL_MAGIC, 2, short)
-#define ADS1115_IOCTL_READ_AIN3 _IOR(ADS1115_IOCTL_MAGIC, 3, short)
+#include "ads1115_uapi.h" // IOCTL commands
 
 #define DEVICE_PATH "/dev/ads1115"
 
 // Convert ADC to voltage (PGA ±4.096V)
-float adc_to_vol(short adc_value) {
+float adc_to_vol(int16_t adc_value) {
     return (adc_value * 4.096) / 32768.0;
 }
 
 int main() {
     int fd;
-    short data;
+    int16_t data;
 
     // Open the device
     fd = open(DEVICE_PATH, O_RDONLY);
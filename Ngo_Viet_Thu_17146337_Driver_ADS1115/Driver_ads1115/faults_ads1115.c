@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "ads1115_lib.h"
+#include "ads1115_bench.h"
+#include "ads1115_model.h"
+
+// Cost of I2C errors and of the retry policy that hides them. Injects NAKs,
+// timeouts and a stuck-busy bus at several rates, repeats single-shot reads
+// under each retry count and reports the reads lost, the throughput and the
+// latency tail. Runs on a software chip with a virtual clock by default; with
+// -d it goes through the kernel driver to an i2c-ads1115-stub chip, setting
+// the stub's fault rates in debugfs and the driver's retry module parameters.
+
+#define FAULTS_MAX_LIST  16
+#define DRIVER_PARAMS    "/sys/module/ads1115_driver/parameters"
+
+enum { FAULT_NAK, FAULT_TIMEOUT, FAULT_BUSY, FAULT_NUM_KINDS };
+
+static const char *const fault_names[FAULT_NUM_KINDS] = { "nak", "timeout", "busy" };
+
+struct fault_result {
+    size_t ok;
+    size_t failed;
+    unsigned long long faults; // Faults injected during the run
+    double rate_sps;           // Successful reads per second
+    struct ads1115_lat_summary lat;
+};
+
+static size_t parse_list(const char *arg, unsigned int *list) {
+    char *copy = strdup(arg), *tok, *save;
+    size_t n = 0;
+
+    for (tok = strtok_r(copy, ",", &save); tok && n < FAULTS_MAX_LIST; tok = strtok_r(NULL, ",", &save))
+        list[n++] = strtoul(tok, NULL, 0);
+    free(copy);
+    return n;
+}
+
+static int write_value(const char *dir, const char *name, unsigned int value) {
+    char path[256];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    f = fopen(path, "w");
+    if (!f)
+        return -errno;
+    fprintf(f, "%u\n", value);
+    return fclose(f) ? -errno : 0;
+}
+
+static int read_stub_faults(const char *dir, unsigned long long *faults) {
+    char path[256], key[32];
+    unsigned long long val;
+    FILE *f;
+    int ret = -ENOENT;
+
+    snprintf(path, sizeof(path), "%s/stats", dir);
+    f = fopen(path, "r");
+    if (!f)
+        return -errno;
+    while (fscanf(f, "%31s %llu", key, &val) == 2) {
+        if (!strcmp(key, "faults")) {
+            *faults = val;
+            ret = 0;
+            break;
+        }
+    }
+    fclose(f);
+    return ret;
+}
+
+// Point the fault source and retry policy at one scenario
+static int configure(struct ads1115_dev *dev, struct ads1115_model *model, const char *stub_dir,
+                     int kind, unsigned int ppm, unsigned int retries, unsigned int backoff_us) {
+    unsigned int rates[FAULT_NUM_KINDS] = { 0 };
+    char name[32];
+    int i, ret;
+
+    rates[kind] = ppm;
+    if (!stub_dir) {
+        model->faults.nak_ppm = rates[FAULT_NAK];
+        model->faults.timeout_ppm = rates[FAULT_TIMEOUT];
+        model->faults.busy_ppm = rates[FAULT_BUSY];
+        return ads1115_set_retry(dev, retries, backoff_us);
+    }
+
+    for (i = 0; i < FAULT_NUM_KINDS; i++) {
+        snprintf(name, sizeof(name), "%s_ppm", fault_names[i]);
+        ret = write_value(stub_dir, name, rates[i]);
+        if (ret < 0)
+            return ret;
+    }
+    ret = write_value(DRIVER_PARAMS, "retries", retries);
+    if (ret < 0)
+        return ret;
+    return write_value(DRIVER_PARAMS, "retry_backoff_us", backoff_us);
+}
+
+static int run(struct ads1115_dev *dev, struct ads1115_model *model, const char *stub_dir,
+               size_t samples, struct fault_result *r) {
+    unsigned long long faults0 = 0, faults1 = 0;
+    uint64_t *lat, t0, t;
+    int16_t value;
+    size_t i;
+    int ret;
+
+    lat = calloc(samples, sizeof(*lat));
+    if (!lat)
+        return -ENOMEM;
+
+    memset(r, 0, sizeof(*r));
+    if (stub_dir && (ret = read_stub_faults(stub_dir, &faults0)) < 0)
+        goto out;
+    if (!stub_dir)
+        faults0 = model->stats.faults;
+
+    // Every call counts towards the latency, a failed read is a late sample
+    t0 = ads1115_dev_now_ns(dev);
+    for (i = 0; i < samples; i++) {
+        t = ads1115_dev_now_ns(dev);
+        ret = ads1115_read_channel(dev, 0, &value);
+        lat[i] = ads1115_dev_now_ns(dev) - t;
+        if (ret < 0)
+            r->failed++;
+        else
+            r->ok++;
+    }
+    t = ads1115_dev_now_ns(dev) - t0;
+
+    if (stub_dir && (ret = read_stub_faults(stub_dir, &faults1)) < 0)
+        goto out;
+    if (!stub_dir)
+        faults1 = model->stats.faults;
+
+    r->faults = faults1 - faults0;
+    r->rate_sps = t ? r->ok / (t / 1e9) : 0;
+    ads1115_lat_summarize(lat, samples, &r->lat);
+    ret = 0;
+out:
+    free(lat);
+    return ret;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-d chrdev -s stub_dir] [options]\n"
+            "  -k kinds      Comma-separated list of nak,timeout,busy (default all)\n"
+            "  -p ppm        Fault rates in parts per million (default 0,1000,10000,50000)\n"
+            "  -R retries    Retry counts to compare (default 0,1,2,4)\n"
+            "  -b us         Backoff before the first retry (default 200)\n"
+            "  -S us         Bus hold time of timeout and busy faults (default 25000)\n"
+            "  -n samples    Reads per scenario (default 2000)\n"
+            "  -d path       Run through the kernel driver instead of the software model\n"
+            "  -s dir        debugfs directory of the stub chip behind -d\n", prog);
+}
+
+int main(int argc, char **argv) {
+    unsigned int ppm[FAULTS_MAX_LIST], retries[FAULTS_MAX_LIST];
+    size_t n_ppm, n_retries, pi, ri, samples = 2000;
+    unsigned int backoff_us = 200, stuck_us = 25000;
+    const char *chrdev = NULL, *stub_dir = NULL, *kinds = "nak,timeout,busy";
+    const char *ppm_arg = "0,1000,10000,50000", *retries_arg = "0,1,2,4";
+    struct ads1115_vclock vclock = { 0 };
+    struct ads1115_model model;
+    struct ads1115_dev *dev;
+    struct fault_result r;
+    char *list, *tok, *save;
+    int opt, kind, ret, failed = 0;
+
+    while ((opt = getopt(argc, argv, "k:p:R:b:S:n:d:s:h")) != -1) {
+        switch (opt) {
+        case 'k': kinds = optarg; break;
+        case 'p': ppm_arg = optarg; break;
+        case 'R': retries_arg = optarg; break;
+        case 'b': backoff_us = strtoul(optarg, NULL, 0); break;
+        case 'S': stuck_us = strtoul(optarg, NULL, 0); break;
+        case 'n': samples = strtoul(optarg, NULL, 0); break;
+        case 'd': chrdev = optarg; break;
+        case 's': stub_dir = optarg; break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!!chrdev != !!stub_dir || !samples) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    n_ppm = parse_list(ppm_arg, ppm);
+    n_retries = parse_list(retries_arg, retries);
+
+    if (chrdev) {
+        dev = ads1115_open_chrdev(chrdev);
+        if (dev && (ret = write_value(stub_dir, "stuck_us", stuck_us)) < 0) {
+            fprintf(stderr, "Failed to set stuck_us: %s\n", strerror(-ret));
+            ads1115_close(dev);
+            return EXIT_FAILURE;
+        }
+    } else {
+        ads1115_model_init(&model, 1);
+        model.signals[0].offset_uv = 1000000;
+        model.faults.stuck_us = stuck_us;
+        dev = ads1115_open_model(&model, &vclock);
+    }
+    if (!dev) {
+        perror("Failed to open the device");
+        return errno;
+    }
+
+    printf("%-8s %7s %7s %7s %7s %7s %9s %9s %9s %9s\n", "kind", "ppm", "retries",
+           "ok", "failed", "faults", "rate_sps", "p50_us", "p99_us", "max_us");
+
+    list = strdup(kinds);
+    for (tok = strtok_r(list, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        for (kind = 0; kind < FAULT_NUM_KINDS; kind++)
+            if (!strcmp(tok, fault_names[kind]))
+                break;
+        if (kind == FAULT_NUM_KINDS) {
+            fprintf(stderr, "Unknown fault kind: %s\n", tok);
+            failed = 1;
+            continue;
+        }
+
+        for (pi = 0; pi < n_ppm; pi++)
+        for (ri = 0; ri < n_retries; ri++) {
+            ret = configure(dev, &model, stub_dir, kind, ppm[pi], retries[ri], backoff_us);
+            if (!ret)
+                ret = run(dev, &model, stub_dir, samples, &r);
+            if (ret < 0) {
+                fprintf(stderr, "%s %u ppm, %u retries: %s\n", tok, ppm[pi], retries[ri], strerror(-ret));
+                failed = 1;
+                continue;
+            }
+            printf("%-8s %7u %7u %7zu %7zu %7llu %9.1f %9.1f %9.1f %9.1f\n", tok, ppm[pi],
+                   retries[ri], r.ok, r.failed, r.faults, r.rate_sps,
+                   r.lat.p50_us, r.lat.p99_us, r.lat.max_us);
+            fflush(stdout);
+        }
+    }
+    free(list);
+
+    // Leave the bus clean and the driver defaults in place for whoever runs next
+    configure(dev, &model, stub_dir, FAULT_NAK, 0, 2, 200);
+    ads1115_close(dev);
+    return failed ? EXIT_FAILURE : 0;
+}
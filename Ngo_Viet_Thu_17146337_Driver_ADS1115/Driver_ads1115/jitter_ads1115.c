@@ -0,0 +1,673 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <math.h>
+#include <dirent.h>
+#include <sched.h>
+#include <signal.h>
+#include <libgen.h>
+#include <sys/wait.h>
+
+#include "ads1115_lib.h"
+#include "ads1115_model.h"
+#include "ads1115_tsfile.h"
+
+// Regularity of sample timestamps, for control loops that care about the
+// spacing of samples more than the mean rate. For each channel the interval
+// between consecutive samples is compared with the period the stream
+// settles at (the median interval): interval statistics, a histogram of the
+// deviation, periods with no sample, sequence drops, and the drift of the
+// achieved conversion rate against the configured DR.
+//
+// Against the driver the run is repeated for every completion mode (and
+// stream strategy) given, written to the device's sysfs config, and every
+// CPU placement: "none" leaves scheduling alone, "shared" pins the reader,
+// the sampler thread and the background load to one CPU, "isolated" pins
+// the load to the other CPUs. -L adds busy CPU or memory load. A software
+// chip (-m) or an existing recording (-i) can be analysed the same way.
+
+#define JITTER_MAX_LIST   8
+#define JITTER_CHUNK      256
+#define JITTER_MISSED     1.5  // Intervals this many periods long contain missed periods
+#define JITTER_MEM_BYTES  (64 << 20) // Buffer each memory load worker sweeps
+#define SYSFS_CLASS       "/sys/class/ads1115"
+#define SAMPLER_COMM      "ads1115-sampler/"
+
+enum { ISOLATE_NONE, ISOLATE_SHARED, ISOLATE_ISOLATED, ISOLATE_NUM };
+
+static const char *const isolate_names[ISOLATE_NUM] = { "none", "shared", "isolated" };
+
+static const unsigned int data_rate_sps[] = { 8, 16, 32, 64, 128, 250, 475, 860 };
+
+// Deviation histogram bucket edges in microseconds, mirrored for early samples
+static const unsigned int hist_edges_us[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000 };
+#define HIST_EDGES (sizeof(hist_edges_us) / sizeof(hist_edges_us[0]))
+#define HIST_BUCKETS (2 * HIST_EDGES + 2)
+
+// Timestamps as they arrive
+struct jitter_trace {
+    uint64_t *ts[ADS1115_NUM_CHANNELS];
+    size_t count[ADS1115_NUM_CHANNELS];
+    size_t alloc[ADS1115_NUM_CHANNELS];
+    uint64_t *all_ts;   // Every sample, for the rate fit against seq
+    uint64_t *all_seq;  // Unwrapped sequence numbers
+    size_t all_count;
+    size_t all_alloc;
+    size_t seq_alloc;
+    uint32_t last_seq;
+    unsigned long long drops;
+};
+
+struct jitter_result {
+    size_t samples;
+    double period_us;   // Median interval
+    double mean_us;
+    double stddev_us;
+    double p99_us;      // Of |interval - period|
+    double max_us;
+    unsigned long long missed;
+    unsigned long long drops;
+    double drift_ppm;   // Achieved conversion period against 1/DR
+    unsigned long long hist[HIST_BUCKETS];
+};
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static size_t parse_names(const char *arg, char **list) {
+    char *copy = strdup(arg), *tok, *save;
+    size_t n = 0;
+
+    for (tok = strtok_r(copy, ",", &save); tok && n < JITTER_MAX_LIST; tok = strtok_r(NULL, ",", &save))
+        list[n++] = strdup(tok);
+    free(copy);
+    return n;
+}
+
+static int grow(void **p, size_t *alloc, size_t need, size_t size) {
+    size_t n = *alloc ? *alloc : 4096;
+    void *q;
+
+    if (need <= *alloc)
+        return 0;
+    while (n < need)
+        n *= 2;
+    q = realloc(*p, n * size);
+    if (!q)
+        return -ENOMEM;
+    *p = q;
+    *alloc = n;
+    return 0;
+}
+
+static int trace_add(struct jitter_trace *t, const struct ads1115_sample *s, size_t n) {
+    size_t i;
+    unsigned int ch;
+
+    for (i = 0; i < n; i++) {
+        ch = s[i].channel;
+        if (ch >= ADS1115_NUM_CHANNELS)
+            continue;
+        if (grow((void **)&t->ts[ch], &t->alloc[ch], t->count[ch] + 1, sizeof(uint64_t)) ||
+            grow((void **)&t->all_ts, &t->all_alloc, t->all_count + 1, sizeof(uint64_t)) ||
+            grow((void **)&t->all_seq, &t->seq_alloc, t->all_count + 1, sizeof(uint64_t)))
+            return -ENOMEM;
+        t->ts[ch][t->count[ch]++] = s[i].timestamp_ns;
+        if (t->all_count) {
+            uint16_t step = (uint16_t)(s[i].seq - t->last_seq);
+
+            if (step)
+                t->drops += step - 1;
+            t->all_seq[t->all_count] = t->all_seq[t->all_count - 1] + step;
+        } else {
+            t->all_seq[0] = 0;
+        }
+        t->last_seq = s[i].seq;
+        t->all_ts[t->all_count++] = s[i].timestamp_ns;
+    }
+    return 0;
+}
+
+static void trace_free(struct jitter_trace *t) {
+    unsigned int ch;
+
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++)
+        free(t->ts[ch]);
+    free(t->all_ts);
+    free(t->all_seq);
+    memset(t, 0, sizeof(*t));
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static unsigned int hist_bucket(double dev_us) {
+    unsigned int i;
+    double mag = fabs(dev_us);
+
+    for (i = 0; i < HIST_EDGES && mag >= hist_edges_us[i]; i++)
+        ;
+    // Buckets run from the earliest samples through 0 to the latest
+    return dev_us < 0 ? HIST_EDGES - i : HIST_EDGES + 1 + i;
+}
+
+// Intervals of the channels in mask, the rate fit over every sample
+static int analyse(const struct jitter_trace *t, uint32_t mask, unsigned int data_rate,
+                   struct jitter_result *r) {
+    double *iv, *dev, sum = 0, sum_sq = 0, ref, sx = 0, sy = 0, sxx = 0, sxy = 0, x, y, k;
+    size_t n = 0, i, m;
+    unsigned int ch;
+
+    memset(r, 0, sizeof(*r));
+    r->samples = t->all_count;
+    r->drops = t->drops;
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++)
+        if (mask & (1u << ch))
+            n += t->count[ch] > 1 ? t->count[ch] - 1 : 0;
+    if (!n)
+        return -ENODATA;
+
+    iv = malloc(n * sizeof(*iv));
+    dev = malloc(n * sizeof(*dev));
+    if (!iv || !dev) {
+        free(iv);
+        free(dev);
+        return -ENOMEM;
+    }
+    for (n = 0, ch = 0; ch < ADS1115_NUM_CHANNELS; ch++)
+        for (i = 1; i < t->count[ch] && (mask & (1u << ch)); i++)
+            iv[n++] = (t->ts[ch][i] - t->ts[ch][i - 1]) / 1e3;
+
+    for (i = 0; i < n; i++) {
+        sum += iv[i];
+        sum_sq += iv[i] * iv[i];
+    }
+    r->mean_us = sum / n;
+    r->stddev_us = sqrt(fmax(sum_sq / n - r->mean_us * r->mean_us, 0));
+    memcpy(dev, iv, n * sizeof(*dev));
+    qsort(dev, n, sizeof(*dev), cmp_double);
+    ref = r->period_us = dev[n / 2];
+
+    for (i = 0; i < n; i++) {
+        if (iv[i] >= JITTER_MISSED * ref)
+            r->missed += (unsigned long long)(iv[i] / ref + 0.5) - 1;
+        r->hist[hist_bucket(iv[i] - ref)]++;
+        dev[i] = fabs(iv[i] - ref);
+    }
+    qsort(dev, n, sizeof(*dev), cmp_double);
+    r->p99_us = dev[n * 99 / 100];
+    r->max_us = dev[n - 1];
+
+    // Least-squares time per conversion slot, drops and all
+    m = t->all_count;
+    for (i = 0; i < m; i++) {
+        x = t->all_seq[i];
+        y = (t->all_ts[i] - t->all_ts[0]) / 1e3;
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    k = m * sxx - sx * sx;
+    if (m > 1 && k > 0)
+        r->drift_ppm = ((m * sxy - sx * sy) / k / (1e6 / data_rate_sps[data_rate]) - 1) * 1e6;
+    free(iv);
+    free(dev);
+    return 0;
+}
+
+static void print_hist(const struct jitter_result *r) {
+    unsigned long long max = 0;
+    unsigned int i, b, bar;
+    char label[32];
+
+    for (b = 0; b < HIST_BUCKETS; b++)
+        if (r->hist[b] > max)
+            max = r->hist[b];
+    for (b = 0; b < HIST_BUCKETS; b++) {
+        if (!r->hist[b])
+            continue;
+        if (b == 0) {
+            snprintf(label, sizeof(label), "<= -%u us", hist_edges_us[HIST_EDGES - 1]);
+        } else if (b < HIST_EDGES) {
+            i = HIST_EDGES - b;
+            snprintf(label, sizeof(label), "(-%u, -%u]", hist_edges_us[i], hist_edges_us[i - 1]);
+        } else if (b == HIST_EDGES) {
+            snprintf(label, sizeof(label), "(-%u, 0)", hist_edges_us[0]);
+        } else if (b == HIST_EDGES + 1) {
+            snprintf(label, sizeof(label), "[0, %u)", hist_edges_us[0]);
+        } else if (b < HIST_BUCKETS - 1) {
+            i = b - HIST_EDGES - 1;
+            snprintf(label, sizeof(label), "[%u, %u)", hist_edges_us[i - 1], hist_edges_us[i]);
+        } else {
+            snprintf(label, sizeof(label), ">= %u us", hist_edges_us[HIST_EDGES - 1]);
+        }
+        bar = (unsigned int)(50 * r->hist[b] / max);
+        printf("  %16s %10llu %.*s\n", label, r->hist[b], bar ? bar : 1,
+               "##################################################");
+    }
+}
+
+static int sysfs_path(char *path, size_t len, const char *devpath, const char *attr) {
+    char *copy = strdup(devpath);
+
+    if (!copy)
+        return -ENOMEM;
+    snprintf(path, len, SYSFS_CLASS "/%s/config/%s", basename(copy), attr);
+    free(copy);
+    return 0;
+}
+
+static int sysfs_write(const char *devpath, const char *attr, const char *value) {
+    char path[256];
+    FILE *f;
+
+    sysfs_path(path, sizeof(path), devpath, attr);
+    f = fopen(path, "w");
+    if (!f)
+        return -errno;
+    fprintf(f, "%s\n", value);
+    return fclose(f) ? -errno : 0;
+}
+
+// Selected entry of a "a [b] c" sysfs choice
+static int sysfs_read_choice(const char *devpath, const char *attr, char *value, size_t len) {
+    char path[256], line[128], *open, *close;
+    FILE *f;
+
+    sysfs_path(path, sizeof(path), devpath, attr);
+    f = fopen(path, "r");
+    if (!f)
+        return -errno;
+    if (!fgets(line, sizeof(line), f) || !(open = strchr(line, '[')) || !(close = strchr(open, ']'))) {
+        fclose(f);
+        return -EINVAL;
+    }
+    fclose(f);
+    *close = '\0';
+    snprintf(value, len, "%s", open + 1);
+    return 0;
+}
+
+// Pin every sampler thread of the driver; they exist only while streaming
+static int place_samplers(int cpu, int fifo_prio) {
+    struct sched_param sp = { .sched_priority = fifo_prio };
+    char path[64], comm[32];
+    struct dirent *de;
+    cpu_set_t set;
+    DIR *proc;
+    FILE *f;
+    pid_t pid;
+    int found = 0;
+
+    proc = opendir("/proc");
+    if (!proc)
+        return -errno;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    while ((de = readdir(proc))) {
+        pid = atoi(de->d_name);
+        if (pid <= 0)
+            continue;
+        snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+        f = fopen(path, "r");
+        if (!f)
+            continue;
+        if (fgets(comm, sizeof(comm), f) && !strncmp(comm, SAMPLER_COMM, strlen(SAMPLER_COMM))) {
+            if (sched_setaffinity(pid, sizeof(set), &set) < 0 ||
+                (fifo_prio > 0 && sched_setscheduler(pid, SCHED_FIFO, &sp) < 0)) {
+                fclose(f);
+                closedir(proc);
+                return -errno;
+            }
+            found++;
+        }
+        fclose(f);
+    }
+    closedir(proc);
+    return found ? 0 : -ESRCH;
+}
+
+static void load_worker(int kind) {
+    volatile unsigned long long x = 1;
+    char *buf;
+
+    if (kind) { // Memory: sweep a buffer much larger than the caches
+        buf = malloc(JITTER_MEM_BYTES);
+        if (!buf)
+            _exit(1);
+        for (;;)
+            memset(buf, (int)x++, JITTER_MEM_BYTES);
+    }
+    for (;;)
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+}
+
+// Background load placed for the isolation mode, cpu being the measured one
+static int start_load(pid_t *pids, unsigned int n, int kind, int isolation, int cpu) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t set;
+    unsigned int i;
+    long c;
+
+    for (i = 0; i < n; i++) {
+        pids[i] = fork();
+        if (pids[i] < 0)
+            return -errno;
+        if (pids[i])
+            continue;
+        CPU_ZERO(&set);
+        if (isolation == ISOLATE_SHARED) {
+            CPU_SET(cpu, &set);
+        } else if (isolation == ISOLATE_ISOLATED) {
+            for (c = 0; c < ncpu; c++)
+                if (c != cpu)
+                    CPU_SET(c, &set);
+        }
+        if (isolation != ISOLATE_NONE && sched_setaffinity(0, sizeof(set), &set) < 0)
+            _exit(1);
+        load_worker(kind);
+    }
+    return 0;
+}
+
+static void stop_load(pid_t *pids, unsigned int n) {
+    unsigned int i;
+
+    for (i = 0; i < n; i++) {
+        if (pids[i] > 0) {
+            kill(pids[i], SIGKILL);
+            waitpid(pids[i], NULL, 0);
+        }
+    }
+}
+
+// Stream for the given time into t. The reader follows the isolation mode;
+// with a driver device so do its sampler threads.
+static int capture(struct ads1115_dev *dev, const struct ads1115_stream_config *cfg, double seconds,
+                   int isolation, int cpu, int fifo_prio, struct jitter_trace *t) {
+    struct ads1115_sample buf[JITTER_CHUNK];
+    struct sched_param sp = { .sched_priority = fifo_prio }, old_sp;
+    cpu_set_t set, old_set;
+    uint64_t end;
+    int ret, old_policy;
+    ssize_t n;
+
+    sched_getaffinity(0, sizeof(old_set), &old_set);
+    old_policy = sched_getscheduler(0);
+    sched_getparam(0, &old_sp);
+    if (isolation != ISOLATE_NONE) {
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) < 0)
+            return -errno;
+    }
+    if (fifo_prio > 0 && sched_setscheduler(0, SCHED_FIFO, &sp) < 0)
+        return -errno;
+
+    ret = ads1115_stream_start(dev, cfg);
+    if (ret < 0)
+        goto out;
+    if (isolation != ISOLATE_NONE && ads1115_poll_fd(dev) >= 0) {
+        ret = place_samplers(cpu, fifo_prio);
+        if (ret < 0) {
+            ads1115_stream_stop(dev);
+            goto out;
+        }
+    }
+    end = ads1115_now_ns() + (uint64_t)(seconds * 1e9);
+    while (!stop && ads1115_now_ns() < end) {
+        n = ads1115_stream_read(dev, buf, JITTER_CHUNK);
+        if (n == -EINTR || n == -EAGAIN)
+            continue;
+        if (n <= 0) {
+            ret = n ? (int)n : -EIO;
+            break;
+        }
+        ret = trace_add(t, buf, n);
+        if (ret < 0)
+            break;
+    }
+    ads1115_stream_stop(dev);
+
+out:
+    sched_setscheduler(0, old_policy, &old_sp);
+    sched_setaffinity(0, sizeof(old_set), &old_set);
+    return ret;
+}
+
+static int cmp_sample_time(const void *a, const void *b) {
+    const struct ads1115_sample *x = a, *y = b;
+
+    return x->timestamp_ns < y->timestamp_ns ? -1 : x->timestamp_ns > y->timestamp_ns;
+}
+
+// Every recorded channel of a device back in stream order, so seq steps
+// and drops come out as they did live
+static int trace_recording(const char *path, unsigned int device, uint32_t *data_rate,
+                           struct jitter_trace *t) {
+    struct ads1115_sample *all = NULL;
+    struct ads1115_ts_cursor cur;
+    struct ads1115_ts_reader *r;
+    size_t count = 0, alloc = 0;
+    unsigned int ch;
+    ssize_t n = 0;
+
+    r = ads1115_ts_open(path);
+    if (!r)
+        return -errno;
+    if (device >= ads1115_ts_info(r)->num_devices) {
+        ads1115_ts_release(r);
+        return -EINVAL;
+    }
+    *data_rate = ads1115_ts_info(r)->devices[device].data_rate;
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS && n >= 0; ch++) {
+        if (ads1115_ts_seek(r, device, ch, 0, UINT64_MAX, &cur) < 0)
+            continue;
+        do {
+            if ((n = grow((void **)&all, &alloc, count + JITTER_CHUNK, sizeof(*all))) < 0)
+                break;
+            n = ads1115_ts_read(r, &cur, all + count, JITTER_CHUNK);
+            if (n > 0)
+                count += n;
+        } while (n > 0);
+    }
+    ads1115_ts_release(r);
+    if (n >= 0) {
+        qsort(all, count, sizeof(*all), cmp_sample_time);
+        n = trace_add(t, all, count);
+    }
+    free(all);
+    return n < 0 ? (int)n : 0;
+}
+
+static void print_row(const char *mode, const char *strategy, const char *isolation,
+                      const struct jitter_result *r) {
+    printf("%-6s %-10s %-8s %8zu %10.1f %10.1f %9.1f %9.1f %9.1f %7llu %7llu %9.0f\n", mode, strategy,
+           isolation, r->samples, r->period_us, r->mean_us, r->stddev_us, r->p99_us, r->max_us,
+           r->missed, r->drops, r->drift_ppm);
+}
+
+static void print_header(void) {
+    printf("%-6s %-10s %-8s %8s %10s %10s %9s %9s %9s %7s %7s %9s\n", "mode", "strategy", "cpus",
+           "samples", "period_us", "mean_us", "stddev_us", "p99_us", "max_us", "missed", "drops",
+           "drift_ppm");
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -d path       Driver device (default /dev/ads1115)\n"
+            "  -m            Software chip in real time instead\n"
+            "  -i file       Analyse a recording instead (-D device, default 0)\n"
+            "  -c mask       Channels (default 0x1)\n"
+            "  -r rate       DR code (default %d)\n"
+            "  -t seconds    Length of each run (default 5)\n"
+            "  -M modes      Completion modes to compare, e.g. sleep,poll,irq (default as set)\n"
+            "  -S strategies Stream strategies to compare, e.g. single,continuous (default as set)\n"
+            "  -I placements none,shared,isolated (default none)\n"
+            "  -C cpu        CPU for shared and isolated placements (default the last)\n"
+            "  -F prio       SCHED_FIFO priority for the reader and sampler\n"
+            "  -L workers    Background load processes (default 0)\n"
+            "  -l kind       cpu or mem load (default cpu)\n"
+            "  -H            Print the deviation histogram of every run\n", prog, ADS1115_DR_MAX);
+}
+
+int main(int argc, char **argv) {
+    struct ads1115_stream_config cfg = { .channel_mask = 0x1, .data_rate = ADS1115_DR_MAX };
+    struct jitter_trace trace = { 0 };
+    struct jitter_result res;
+    struct ads1115_model model;
+    struct ads1115_dev *dev;
+    char *modes[JITTER_MAX_LIST], *strategies[JITTER_MAX_LIST], *placements[JITTER_MAX_LIST];
+    char old_mode[32] = "", old_strategy[32] = "";
+    const char *path = "/dev/ads1115", *recording = NULL;
+    size_t num_modes = 0, num_strategies = 0, num_placements = 0, mi, si, pi;
+    unsigned int workers = 0, device = 0;
+    pid_t load[64];
+    double seconds = 5;
+    int opt, use_model = 0, cpu = -1, fifo_prio = 0, load_kind = 0, hist = 0, isolation, ret;
+    int status = 0;
+    struct sigaction sa;
+
+    while ((opt = getopt(argc, argv, "d:mi:D:c:r:t:M:S:I:C:F:L:l:Hh")) != -1) {
+        switch (opt) {
+        case 'd': path = optarg; break;
+        case 'm': use_model = 1; break;
+        case 'i': recording = optarg; break;
+        case 'D': device = strtoul(optarg, NULL, 0); break;
+        case 'c': cfg.channel_mask = strtoul(optarg, NULL, 0); break;
+        case 'r': cfg.data_rate = strtoul(optarg, NULL, 0); break;
+        case 't': seconds = strtod(optarg, NULL); break;
+        case 'M': num_modes = parse_names(optarg, modes); break;
+        case 'S': num_strategies = parse_names(optarg, strategies); break;
+        case 'I': num_placements = parse_names(optarg, placements); break;
+        case 'C': cpu = strtol(optarg, NULL, 0); break;
+        case 'F': fifo_prio = strtol(optarg, NULL, 0); break;
+        case 'L': workers = strtoul(optarg, NULL, 0); break;
+        case 'l': load_kind = !strcmp(optarg, "mem"); break;
+        case 'H': hist = 1; break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    // Software chips have neither completion modes nor strategies
+    if (!num_modes || use_model) {
+        modes[0] = "-";
+        num_modes = 1;
+    }
+    if (!num_strategies || use_model) {
+        strategies[0] = "-";
+        num_strategies = 1;
+    }
+    if (!num_placements)
+        placements[num_placements++] = "none";
+    if (cpu < 0)
+        cpu = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+    if (cfg.data_rate > ADS1115_DR_MAX || workers > sizeof(load) / sizeof(load[0]) ||
+        !(cfg.channel_mask & ((1u << ADS1115_NUM_CHANNELS) - 1))) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (recording) {
+        ret = trace_recording(recording, device, &cfg.data_rate, &trace);
+        if (!ret)
+            ret = analyse(&trace, cfg.channel_mask, cfg.data_rate, &res);
+        if (ret < 0) {
+            fprintf(stderr, "Failed to analyse %s: %s\n", recording, strerror(-ret));
+            return EXIT_FAILURE;
+        }
+        print_header();
+        print_row("-", "-", "-", &res);
+        if (hist)
+            print_hist(&res);
+        trace_free(&trace);
+        return 0;
+    }
+
+    if (use_model) {
+        ads1115_model_init(&model, 1);
+        dev = ads1115_open_model(&model, NULL);
+        path = "model";
+    } else {
+        dev = ads1115_open_chrdev(path);
+    }
+    if (!dev) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    if (!use_model) {
+        sysfs_read_choice(path, "completion_mode", old_mode, sizeof(old_mode));
+        sysfs_read_choice(path, "stream_strategy", old_strategy, sizeof(old_strategy));
+    }
+
+    print_header();
+
+    // No SA_RESTART: a signal must end the run in progress
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    for (mi = 0; mi < num_modes && !stop; mi++) {
+        for (si = 0; si < num_strategies && !stop; si++) {
+            for (pi = 0; pi < num_placements && !stop; pi++) {
+                for (isolation = 0; isolation < ISOLATE_NUM; isolation++)
+                    if (!strcmp(placements[pi], isolate_names[isolation]))
+                        break;
+                if (isolation == ISOLATE_NUM) {
+                    fprintf(stderr, "Unknown placement %s\n", placements[pi]);
+                    status = EXIT_FAILURE;
+                    continue;
+                }
+                if (!use_model &&
+                    (((ret = strcmp(modes[mi], "-") ? sysfs_write(path, "completion_mode", modes[mi]) : 0) < 0) ||
+                     ((ret = strcmp(strategies[si], "-") ?
+                             sysfs_write(path, "stream_strategy", strategies[si]) : 0) < 0))) {
+                    fprintf(stderr, "%s/%s: unavailable: %s\n", modes[mi], strategies[si], strerror(-ret));
+                    continue;
+                }
+
+                memset(load, 0, sizeof(load));
+                ret = start_load(load, workers, load_kind, isolation, cpu);
+                if (!ret)
+                    ret = capture(dev, &cfg, seconds, isolation, cpu, fifo_prio, &trace);
+                stop_load(load, workers);
+                if (!ret)
+                    ret = analyse(&trace, cfg.channel_mask, cfg.data_rate, &res);
+                trace_free(&trace);
+                if (ret < 0) {
+                    fprintf(stderr, "%s/%s/%s: %s\n", modes[mi], strategies[si], placements[pi],
+                            strerror(-ret));
+                    status = EXIT_FAILURE;
+                    continue;
+                }
+                print_row(modes[mi], strategies[si], placements[pi], &res);
+                if (hist)
+                    print_hist(&res);
+                fflush(stdout);
+            }
+        }
+    }
+
+    // Leave the device as it was found
+    if (old_mode[0])
+        sysfs_write(path, "completion_mode", old_mode);
+    if (old_strategy[0])
+        sysfs_write(path, "stream_strategy", old_strategy);
+    ads1115_close(dev);
+    return status;
+}
@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <math.h>
+
+#include "ads1115_lib.h"
+#include "ads1115_bench.h"
+#include "ads1115_model.h"
+
+// Performance regression check. Runs a fixed scenario matrix (channels x
+// data rates x access modes) and compares bus transactions
+// per sample, syscalls per sample, latency percentiles and achieved rate
+// against a checked-in baseline. By default the scenarios run on software
+// chips with a virtual clock, so every number is reproducible; with -d they
+// run through the kernel driver on i2c-ads1115-stub chips instead.
+
+#define PERF_SAMPLES     256 // Samples per scenario
+#define PERF_BURST_LEN   32
+#define PERF_EPSILON     1e-9
+
+enum { M_TX, M_SYSCALLS, M_P50, M_P99, M_RATE, M_COUNT };
+
+static const char *const metric_names[M_COUNT] = {
+    "tx/sample", "syscalls/sample", "p50_us", "p99_us", "rate_sps",
+};
+
+struct scenario {
+    char name[48];
+    enum ads1115_bench_mode mode;
+    uint32_t channel_mask;
+    uint32_t data_rate;
+};
+
+struct baseline_entry {
+    char name[48];
+    double m[M_COUNT]; // NAN when not checked
+    int seen;          // Produced by this run
+};
+
+static const uint32_t matrix_masks[] = { 0x1, 0xF };
+static const uint32_t matrix_rates[] = { 4, 7 };
+
+// Only streams take a data rate, single and scan reads use each channel's
+static int rate_swept(int mode) {
+    return mode == ADS1115_BENCH_BURST || mode == ADS1115_BENCH_STREAM;
+}
+
+// Single reads and bursts use only the first channel of the mask
+static int mask_swept(int mode) {
+    return mode == ADS1115_BENCH_SCAN || mode == ADS1115_BENCH_STREAM;
+}
+
+static struct baseline_entry *baseline;
+static size_t baseline_len;
+
+static int load_baseline(const char *path) {
+    char line[256], v[M_COUNT][32];
+    struct baseline_entry *e;
+    FILE *f = fopen(path, "r");
+    int i;
+
+    if (!f)
+        return -errno;
+
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+        baseline = realloc(baseline, (baseline_len + 1) * sizeof(*baseline));
+        e = &baseline[baseline_len];
+        if (sscanf(line, "%47s %31s %31s %31s %31s %31s", e->name,
+                   v[0], v[1], v[2], v[3], v[4]) != 1 + M_COUNT)
+            continue;
+        e->seen = 0;
+        for (i = 0; i < M_COUNT; i++)
+            e->m[i] = strcmp(v[i], "-") ? strtod(v[i], NULL) : NAN;
+        baseline_len++;
+    }
+    fclose(f);
+    return 0;
+}
+
+static struct baseline_entry *find_baseline(const char *name) {
+    size_t i;
+
+    for (i = 0; i < baseline_len; i++)
+        if (!strcmp(baseline[i].name, name))
+            return &baseline[i];
+    return NULL;
+}
+
+static int read_stub_transactions(const char *path, unsigned long long *tx) {
+    char key[32];
+    unsigned long long val;
+    FILE *f = fopen(path, "r");
+    int ret = -ENOENT;
+
+    if (!f)
+        return -errno;
+    while (fscanf(f, "%31s %llu", key, &val) == 2) {
+        if (!strcmp(key, "transactions")) {
+            *tx = val;
+            ret = 0;
+            break;
+        }
+    }
+    fclose(f);
+    return ret;
+}
+
+static void setup_model(struct ads1115_model *model) {
+    int i;
+
+    ads1115_model_init(model, 1);
+    for (i = 0; i < ADS1115_MODEL_NUM_INPUTS; i++) {
+        model->signals[i].offset_uv = (i + 1) * 500000;
+        model->signals[i].noise_uv = 200;
+    }
+}
+
+// Run one scenario on a single device
+static int run_scenario(const struct scenario *sc, const char *chrdev, const char *stub_stats,
+                        double m[M_COUNT]) {
+    struct ads1115_bench_params p = { .mode = sc->mode, .channel_mask = sc->channel_mask,
+                                      .data_rate = sc->data_rate, .samples = PERF_SAMPLES,
+                                      .burst_len = PERF_BURST_LEN };
+    struct ads1115_model model;
+    struct ads1115_dev *dev;
+    struct ads1115_vclock vclock = { 0 };
+    struct ads1115_bench_result r;
+    unsigned long long tx0 = 0, tx1 = 0;
+    int ret = 0;
+
+    if (chrdev) {
+        dev = ads1115_open_chrdev(chrdev);
+    } else {
+        setup_model(&model);
+        dev = ads1115_open_model(&model, &vclock);
+    }
+    if (!dev)
+        return -errno;
+
+    if (stub_stats)
+        ret = read_stub_transactions(stub_stats, &tx0);
+    if (!ret)
+        ret = ads1115_bench_run(dev, &p, &r);
+    if (!ret && stub_stats)
+        ret = read_stub_transactions(stub_stats, &tx1);
+    ads1115_close(dev);
+    if (ret)
+        return ret;
+
+    m[M_TX] = stub_stats ? (double)(tx1 - tx0) / r.samples : r.transactions_per_sample;
+    m[M_SYSCALLS] = r.syscalls_per_sample;
+    m[M_P50] = r.lat.p50_us;
+    m[M_P99] = r.lat.p99_us;
+    // The model produces streamed samples when they are read, so their
+    // delivery latency on the virtual clock says nothing
+    if (!chrdev && (sc->mode == ADS1115_BENCH_BURST || sc->mode == ADS1115_BENCH_STREAM))
+        m[M_P50] = m[M_P99] = NAN;
+    m[M_RATE] = r.elapsed_s > 0 ? r.samples / r.elapsed_s : 0;
+    return 0;
+}
+
+// Baseline line of one scenario, '-' for metrics not measured
+static void write_baseline(FILE *out, const char *name, const double m[M_COUNT]) {
+    int i;
+
+    fprintf(out, "%s", name);
+    for (i = 0; i < M_COUNT; i++) {
+        if (isnan(m[i]))
+            fprintf(out, " -");
+        else
+            fprintf(out, i == M_TX || i == M_SYSCALLS ? " %.3f" : " %.1f", m[i]);
+    }
+    fprintf(out, "\n");
+}
+
+// Returns 1 when the metric got worse than the baseline beyond tolerance
+static int compare(int metric, double base, double cur, double tol, double count_tol) {
+    double t = metric == M_TX || metric == M_SYSCALLS ? count_tol : tol;
+
+    if (isnan(base))
+        return 0;
+    if (isnan(cur))
+        return 1; // Checked metric no longer measured
+    if (metric == M_RATE)
+        return cur < base * (1 - t) - PERF_EPSILON;
+    return cur > base * (1 + t) + PERF_EPSILON;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-f baseline] [-u] [-t tolerance] [-T count_tolerance]\n"
+            "          [-d chrdev -s stub_stats]\n"
+            "  -f file   Baseline file (default perf_baseline.txt)\n"
+            "  -u        Rewrite the baseline with the current results\n"
+            "  -t frac   Allowed regression of latency and rate (default 0.05)\n"
+            "  -T frac   Allowed regression of transaction and syscall counts (default 0)\n"
+            "  -d path   Run through the kernel driver instead of the software model\n"
+            "  -s path   debugfs stats file of the stub chip behind -d\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *baseline_path = "perf_baseline.txt", *chrdev = NULL, *stub_stats = NULL;
+    double tol = 0.05, count_tol = 0.0, m[M_COUNT];
+    struct baseline_entry *base;
+    size_t bi;
+    struct scenario sc;
+    FILE *out = NULL;
+    size_t mi, ri;
+    int update = 0, regressions = 0, opt, mode, i, bad, ret;
+
+    while ((opt = getopt(argc, argv, "f:ut:T:d:s:h")) != -1) {
+        switch (opt) {
+        case 'f': baseline_path = optarg; break;
+        case 'u': update = 1; break;
+        case 't': tol = atof(optarg); break;
+        case 'T': count_tol = atof(optarg); break;
+        case 'd': chrdev = optarg; break;
+        case 's': stub_stats = optarg; break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!!chrdev != !!stub_stats) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (update) {
+        out = fopen(baseline_path, "w");
+        if (!out) {
+            perror("Failed to open the baseline");
+            return errno;
+        }
+        fprintf(out, "# scenario tx/sample syscalls/sample p50_us p99_us rate_sps ('-' = not checked)\n");
+    } else if ((ret = load_baseline(baseline_path)) < 0) {
+        fprintf(stderr, "Failed to load %s: %s\n", baseline_path, strerror(-ret));
+        return EXIT_FAILURE;
+    }
+
+    for (mode = 0; mode < ADS1115_BENCH_NUM_MODES; mode++)
+    for (mi = 0; mi < sizeof(matrix_masks) / sizeof(matrix_masks[0]); mi++)
+    for (ri = 0; ri < sizeof(matrix_rates) / sizeof(matrix_rates[0]); ri++) {
+        sc.mode = mode;
+        sc.channel_mask = matrix_masks[mi];
+        sc.data_rate = matrix_rates[ri];
+        if ((!rate_swept(mode) && ri) || (!mask_swept(mode) && mi))
+            continue;
+        if (rate_swept(mode))
+            snprintf(sc.name, sizeof(sc.name), "%s-%s-c%d-r%u", chrdev ? "kernel" : "model",
+                     ads1115_bench_mode_name(mode), __builtin_popcount(sc.channel_mask),
+                     sc.data_rate);
+        else
+            snprintf(sc.name, sizeof(sc.name), "%s-%s-c%d", chrdev ? "kernel" : "model",
+                     ads1115_bench_mode_name(mode), __builtin_popcount(sc.channel_mask));
+
+        ret = run_scenario(&sc, chrdev, stub_stats, m);
+        if (ret < 0) {
+            fprintf(stderr, "%-28s FAILED to run: %s\n", sc.name, strerror(-ret));
+            regressions++;
+            continue;
+        }
+
+        if (update) {
+            write_baseline(out, sc.name, m);
+            continue;
+        }
+
+        base = find_baseline(sc.name);
+        if (!base) {
+            printf("%-28s NEW: not in the baseline, rerun with -u\n", sc.name);
+            regressions++;
+            continue;
+        }
+        base->seen = 1;
+        bad = 0;
+        for (i = 0; i < M_COUNT; i++) {
+            if (compare(i, base->m[i], m[i], tol, count_tol)) {
+                printf("%-28s REGRESSION %s: baseline %.3f, now %.3f\n",
+                       sc.name, metric_names[i], base->m[i], m[i]);
+                bad = 1;
+            }
+        }
+        if (!bad)
+            printf("%-28s ok\n", sc.name);
+        regressions += bad;
+    }
+
+    // A scenario dropped or renamed since the baseline was written
+    for (bi = 0; bi < baseline_len; bi++) {
+        if (!baseline[bi].seen) {
+            printf("%-28s MISSING: in the baseline but not run\n", baseline[bi].name);
+            regressions++;
+        }
+    }
+
+    if (out)
+        fclose(out);
+    free(baseline);
+
+    if (regressions) {
+        printf("%d scenario(s) failed\n", regressions);
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,358 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "ads1115_lib.h"
+#include "ads1115_model.h"
+#include "ads1115_tsfile.h"
+
+// Plays a recorded device (any ads1115_tsfile.h file, e.g. from
+// acquire_ads1115 on real hardware) back on the inputs of a software chip,
+// as recorded or sped up, so the whole stack from driver to consumers can be
+// benchmarked on real signals. With -k the recording is loaded into a chip
+// of i2c-ads1115-stub through debugfs and keeps playing after the tool exits;
+// stream /dev/ads1115 with acquire_ads1115 or any other consumer. Otherwise
+// the tool streams the replay from an in-process software chip, checks every
+// sample against the recording and reports the rate, optionally writing the
+// replayed stream to a new recording.
+//
+// Recorded codes are turned back into pin voltages with the recorded gain,
+// or -g where the recording does not know it; consumers must convert at the
+// same gain to see the recorded codes.
+
+#define REPLAY_CHUNK    1024
+#define REPLAY_STUB_DIR "/sys/kernel/debug/ads1115_stub"
+
+static const int32_t fsr_uv[] = { 6144000, 4096000, 2048000, 1024000, 512000, 256000 };
+
+struct replay_channel {
+    struct ads1115_model_replay_point *points;
+    uint32_t count;
+    uint8_t pga;
+    unsigned long long replayed; // Samples streamed back
+    unsigned long long matched;  // Equal to the recording
+};
+
+// Smallest voltage that the model converts back to code, so the recorded
+// codes come out unchanged
+static int32_t code_to_uv(int16_t code, uint8_t pga) {
+    int64_t mag = ((int64_t)abs(code) * fsr_uv[pga] + 32767) / 32768;
+
+    return code < 0 ? -mag : mag;
+}
+
+static int16_t uv_to_code(int32_t uv, uint8_t pga) {
+    int64_t code = (int64_t)uv * 32768 / fsr_uv[pga];
+
+    return code > 32767 ? 32767 : code < -32768 ? -32768 : code;
+}
+
+// Samples of one recorded channel as replay points relative to t0
+static int load_channel(struct ads1115_ts_reader *r, unsigned int device, unsigned int channel,
+                        uint64_t t0, struct replay_channel *c) {
+    struct ads1115_sample buf[REPLAY_CHUNK];
+    struct ads1115_model_replay_point *points;
+    struct ads1115_ts_cursor cur;
+    size_t alloc = 0, need;
+    ssize_t n, i;
+    int ret;
+
+    ret = ads1115_ts_seek(r, device, channel, 0, UINT64_MAX, &cur);
+    if (ret < 0)
+        return ret;
+    while ((n = ads1115_ts_read(r, &cur, buf, REPLAY_CHUNK)) > 0) {
+        need = c->count + (size_t)n; // n > 0 here
+        if (need > alloc) {
+            alloc = alloc ? 2 * alloc : 4096;
+            while (alloc < need)
+                alloc *= 2;
+            points = realloc(c->points, alloc * sizeof(*points));
+            if (!points)
+                return -ENOMEM;
+            c->points = points;
+        }
+        for (i = 0; i < n; i++) {
+            c->points[c->count].time_ns = buf[i].timestamp_ns - t0;
+            c->points[c->count].uv = code_to_uv(buf[i].value, c->pga);
+            c->points[c->count++].reserved = 0;
+        }
+    }
+    return n;
+}
+
+static int write_file(const char *path, const void *buf, size_t len) {
+    size_t off = 0;
+    ssize_t n;
+    int fd, ret = 0;
+
+    fd = open(path, O_WRONLY | O_TRUNC);
+    if (fd < 0)
+        return -errno;
+    while (off < len) {
+        n = write(fd, (const char *)buf + off, len - off);
+        if (n < 0) {
+            ret = -errno;
+            break;
+        }
+        off += n;
+    }
+    if (close(fd) < 0 && !ret)
+        ret = -errno;
+    return ret;
+}
+
+static int write_stub(const char *dir, const char *name, const void *buf, size_t len) {
+    char path[256];
+    int ret;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    ret = write_file(path, buf, len);
+    if (ret < 0)
+        fprintf(stderr, "Failed to write %s: %s\n", path, strerror(-ret));
+    return ret;
+}
+
+// Load the recording into a chip of i2c-ads1115-stub and start it playing
+static int replay_stub(unsigned int addr, struct replay_channel *chans, uint32_t mask,
+                       unsigned int speed_pct, int loop) {
+    char dir[64], name[32], line[64];
+    unsigned int ch;
+    int len;
+
+    snprintf(dir, sizeof(dir), REPLAY_STUB_DIR "/0x%02x", addr);
+    len = snprintf(line, sizeof(line), "%u\n", speed_pct);
+    if (write_stub(dir, "replay_speed_pct", line, len) < 0 ||
+        write_stub(dir, "replay_loop", loop ? "Y\n" : "N\n", 2) < 0 ||
+        write_stub(dir, "vdd_uv", "5500000\n", 8) < 0)
+        return -1;
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++) {
+        if (!(mask & (1u << ch)))
+            continue;
+        snprintf(name, sizeof(name), "ain%u_replay", ch);
+        if (write_stub(dir, name, chans[ch].points, chans[ch].count * sizeof(*chans[ch].points)) < 0)
+            return -1;
+        snprintf(name, sizeof(name), "ain%u", ch);
+        len = snprintf(line, sizeof(line), "%u 0 0 0 0\n", ADS1115_SIGNAL_REPLAY);
+        if (write_stub(dir, name, line, len) < 0)
+            return -1;
+    }
+    // All channels start together
+    return write_stub(dir, "replay_start", "1\n", 2) < 0 ? -1 : 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] file\n"
+            "  -D device     Recorded device to play (default 0)\n"
+            "  -x speed      Playback speed, 1 as recorded (default 1)\n"
+            "  -l            Loop the recording\n"
+            "  -g pga        PGA code of channels recorded without one (default %d)\n"
+            "  -k addr       Load into i2c-ads1115-stub chip addr and exit\n"
+            "In-process replay (without -k):\n"
+            "  -r rate       DR code to stream at (default the recorded one)\n"
+            "  -t seconds    Length of the replay (default the recording at -x)\n"
+            "  -R            Run in real time (default simulated time)\n"
+            "  -o file       Write the replayed stream as a recording\n", prog, ADS1115_PGA_DEFAULT);
+}
+
+int main(int argc, char **argv) {
+    struct replay_channel chans[ADS1115_NUM_CHANNELS] = { 0 };
+    struct ads1115_vclock vclock = { .now_ns = 1000000000ull };
+    struct ads1115_stream_reconfig rc = { .pga = { ADS1115_PGA_KEEP, ADS1115_PGA_KEEP,
+                                                   ADS1115_PGA_KEEP, ADS1115_PGA_KEEP } };
+    struct ads1115_stream_config cfg;
+    struct ads1115_sample buf[REPLAY_CHUNK];
+    const struct ads1115_ts_header *hdr;
+    const struct ads1115_ts_index_entry *idx;
+    struct ads1115_ts_writer *out = NULL;
+    struct ads1115_ts_reader *r;
+    struct ads1115_model model;
+    struct ads1115_dev *dev;
+    unsigned int device = 0, ch, default_pga = ADS1115_PGA_DEFAULT, speed_pct, stub_addr = 0;
+    unsigned long long total = 0;
+    uint64_t t0 = UINT64_MAX, span = 0, start, end, period;
+    uint16_t generation = 0;
+    double speed = 1, seconds = 0, wall, elapsed;
+    const char *path = NULL;
+    int opt, loop = 0, realtime = 0, rate = -1, ret = EXIT_FAILURE, reconfig = 0;
+    size_t entries, i;
+    ssize_t n;
+
+    while ((opt = getopt(argc, argv, "D:x:lg:k:r:t:Ro:h")) != -1) {
+        switch (opt) {
+        case 'D': device = strtoul(optarg, NULL, 0); break;
+        case 'x': speed = strtod(optarg, NULL); break;
+        case 'l': loop = 1; break;
+        case 'g': default_pga = strtoul(optarg, NULL, 0); break;
+        case 'k': stub_addr = strtoul(optarg, NULL, 0); break;
+        case 'r': rate = strtol(optarg, NULL, 0); break;
+        case 't': seconds = strtod(optarg, NULL); break;
+        case 'R': realtime = 1; break;
+        case 'o': path = optarg; break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    speed_pct = (unsigned int)(speed * 100 + 0.5);
+    if (optind != argc - 1 || !speed_pct || default_pga > ADS1115_PGA_MAX || rate > ADS1115_DR_MAX ||
+        (stub_addr && (stub_addr < 0x48 || stub_addr > 0x4b))) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    r = ads1115_ts_open(argv[optind]);
+    if (!r) {
+        fprintf(stderr, "Failed to open %s: %s\n", argv[optind], strerror(errno));
+        return EXIT_FAILURE;
+    }
+    hdr = ads1115_ts_info(r);
+    if (device >= hdr->num_devices) {
+        fprintf(stderr, "The recording has %u devices\n", hdr->num_devices);
+        goto out;
+    }
+    cfg.channel_mask = hdr->devices[device].channel_mask & ((1u << ADS1115_NUM_CHANNELS) - 1);
+    cfg.data_rate = rate >= 0 ? (unsigned int)rate : hdr->devices[device].data_rate;
+
+    // Channels share the timeline of the device's first sample
+    idx = ads1115_ts_index(r, &entries);
+    for (i = 0; i < entries; i++)
+        if (idx[i].device == device && idx[i].first_ns < t0)
+            t0 = idx[i].first_ns;
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++) {
+        if (!(cfg.channel_mask & (1u << ch)))
+            continue;
+        chans[ch].pga = hdr->devices[device].pga[ch];
+        if (chans[ch].pga > ADS1115_PGA_MAX)
+            chans[ch].pga = default_pga;
+        if (chans[ch].pga != ADS1115_PGA_DEFAULT) {
+            rc.pga[ch] = chans[ch].pga;
+            reconfig = 1;
+        }
+        n = load_channel(r, device, ch, t0, &chans[ch]);
+        if (n < 0) {
+            fprintf(stderr, "Failed to read AIN%u: %s\n", ch, strerror(-n));
+            goto out;
+        }
+        if (!chans[ch].count)
+            cfg.channel_mask &= ~(1u << ch);
+        else if (chans[ch].points[chans[ch].count - 1].time_ns > span)
+            span = chans[ch].points[chans[ch].count - 1].time_ns;
+    }
+    if (!cfg.channel_mask) {
+        fprintf(stderr, "Device %u has no samples\n", device);
+        goto out;
+    }
+    fprintf(stderr, "Device %u: channel_mask 0x%x, %.3f s recorded, playing at %.2fx%s\n", device,
+            cfg.channel_mask, span / 1e9, speed_pct / 100.0, loop ? " in a loop" : "");
+
+    if (stub_addr) {
+        if (replay_stub(stub_addr, chans, cfg.channel_mask, speed_pct, loop) == 0) {
+            fprintf(stderr, "Playing on stub chip 0x%02x\n", stub_addr);
+            ret = 0;
+        }
+        goto out;
+    }
+
+    ads1115_model_init(&model, 1);
+    model.vdd_uv = 5500000; // Recordings at +/-6.144V must not clamp
+    model.replay_speed_pct = speed_pct;
+    model.replay_loop = loop;
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++) {
+        model.signals[ch].type = ADS1115_SIGNAL_REPLAY;
+        model.replay[ch].points = chans[ch].points;
+        model.replay[ch].count = chans[ch].count;
+    }
+    dev = ads1115_open_model(&model, realtime ? NULL : &vclock);
+    if (!dev) {
+        perror("Failed to open a software chip");
+        goto out;
+    }
+    if (path) {
+        struct ads1115_ts_header info = { .num_devices = 1 };
+
+        info.devices[0].channel_mask = cfg.channel_mask;
+        info.devices[0].data_rate = cfg.data_rate;
+        for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++)
+            info.devices[0].pga[ch] = chans[ch].count ? chans[ch].pga : ADS1115_TS_PGA_UNKNOWN;
+        out = ads1115_ts_create(path, &info);
+        if (!out) {
+            fprintf(stderr, "Failed to create %s: %s\n", path, strerror(errno));
+            ads1115_close(dev);
+            goto out;
+        }
+    }
+
+    n = ads1115_stream_start(dev, &cfg);
+    if (!n && reconfig) {
+        rc.channel_mask = cfg.channel_mask;
+        rc.data_rate = cfg.data_rate;
+        n = ads1115_stream_reconfig(dev, &rc);
+        generation = rc.generation;
+    }
+    if (n < 0) {
+        fprintf(stderr, "Failed to start streaming: %s\n", strerror(-n));
+        ads1115_close(dev);
+        goto out;
+    }
+    start = ads1115_dev_now_ns(dev);
+    model.replay_start_ns = start;
+    end = start + (seconds > 0 ? (uint64_t)(seconds * 1e9) : span * 100 / speed_pct);
+    period = ads1115_model_conv_time_ns(&model, cfg.data_rate << 5);
+    wall = ads1115_now_ns();
+
+    while (ads1115_dev_now_ns(dev) < end) {
+        n = ads1115_stream_read(dev, buf, REPLAY_CHUNK);
+        if (n < 0) {
+            fprintf(stderr, "Failed to read the stream: %s\n", strerror(-n));
+            break;
+        }
+        if (out && ads1115_ts_append(out, 0, buf, n) < 0) {
+            fprintf(stderr, "Failed to write %s: %s\n", path, strerror(errno));
+            break;
+        }
+        for (i = 0; i < (size_t)n; i++) {
+            struct replay_channel *c = &chans[buf[i].channel];
+            uint64_t ts = buf[i].timestamp_ns;
+
+            if (buf[i].generation != generation)
+                continue;
+            c->replayed++;
+            // The conversion sampled the input up to one period before it was
+            // read. Above 1x several points fall in one period and only the
+            // converted one can match.
+            if (buf[i].value == uv_to_code(ads1115_model_replay_uv(&model, buf[i].channel, ts), c->pga) ||
+                buf[i].value == uv_to_code(ads1115_model_replay_uv(&model, buf[i].channel,
+                                                                   ts > period ? ts - period : 0), c->pga))
+                c->matched++;
+        }
+    }
+    wall = (ads1115_now_ns() - wall) / 1e9;
+    elapsed = (ads1115_dev_now_ns(dev) - start) / 1e9;
+    ads1115_stream_stop(dev);
+    ads1115_close(dev);
+    if (out && ads1115_ts_close(out) < 0)
+        fprintf(stderr, "Failed to finish %s: %s\n", path, strerror(errno));
+
+    printf("%-7s %4s %10s %10s %8s\n", "channel", "pga", "recorded", "replayed", "matched");
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++) {
+        if (!chans[ch].count)
+            continue;
+        printf("AIN%-4u %4u %10u %10llu %7.2f%%\n", ch, chans[ch].pga, chans[ch].count, chans[ch].replayed,
+               chans[ch].replayed ? 100.0 * chans[ch].matched / chans[ch].replayed : 0.0);
+        total += chans[ch].replayed;
+    }
+    printf("%llu samples in %.3f s device time, %.3f s wall, %.0f samples/s\n", total,
+           elapsed, wall, wall > 0 ? total / wall : 0.0);
+    ret = 0;
+
+out:
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++)
+        free(chans[ch].points);
+    ads1115_ts_release(r);
+    return ret;
+}
@@ -0,0 +1,487 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "ads1115_lib.h"
+#include "ads1115_bench.h"
+
+// Contention stress for the kernel driver. N clients, each with its own open
+// file, run a random mix of single reads, scans and short streams against
+// one or more devices for a fixed time, and every value is checked against
+// the channel it claims to come from. The inputs carry channel-distinct DC
+// levels, set on i2c-ads1115-stub chips with -s or wired up on a board and
+// given with -e. Reports throughput, fairness between clients (Jain's index
+// and the slowest client against the fastest) and latency tails per
+// operation as N grows. Clients are processes, or threads with -T.
+
+#define STRESS_MAX_CLIENTS 64
+#define STRESS_MAX_DEVICES 4
+#define STRESS_MAX_LIST    16
+#define STRESS_LAT_MAX     (1 << 16) // Latencies kept per client and operation
+#define STRESS_LEVEL_UV    600000    // AINn is held at (n + 1) * STRESS_LEVEL_UV on stub chips
+#define STRESS_NOISE_UV    1000
+#define STRESS_STUB_DIR    "/sys/kernel/debug/ads1115_stub/0x48"
+
+enum { STRESS_SINGLE, STRESS_SCAN, STRESS_STREAM, STRESS_NUM_OPS };
+
+static const char *const op_names[STRESS_NUM_OPS] = { "single", "scan", "stream" };
+
+static const int32_t fsr_uv[] = { 6144000, 4096000, 2048000, 1024000, 512000, 256000 };
+
+struct stress_client {
+    unsigned long long ops[STRESS_NUM_OPS];
+    unsigned long long samples;    // Values returned by every operation
+    unsigned long long mismatches; // Values outside their channel's band
+    unsigned long long errors;     // Failed calls
+    unsigned long long drops;      // Stream sequence gaps
+    int first_error;               // errno of the first failed call
+    size_t nlat[STRESS_NUM_OPS];
+    uint64_t *lat[STRESS_NUM_OPS]; // STRESS_LAT_MAX each, in the shared mapping
+};
+
+// Shared with the clients, across fork() too
+struct stress_shared {
+    volatile int ready;
+    volatile int go;
+    volatile int stop;
+    struct stress_client clients[STRESS_MAX_CLIENTS];
+};
+
+struct stress_params {
+    const char *devices[STRESS_MAX_DEVICES];
+    unsigned int num_devices;
+    uint32_t channel_mask;
+    uint32_t data_rate;
+    unsigned int weights[STRESS_NUM_OPS];
+    unsigned int stream_samples; // Samples taken per stream before stopping
+    int32_t expected[ADS1115_NUM_CHANNELS]; // Code each input should read
+    int32_t tolerance;
+};
+
+static struct stress_params params = {
+    .channel_mask = 0xf,
+    .data_rate = ADS1115_DR_MAX,
+    .weights = { 4, 2, 1 },
+    .stream_samples = 64,
+};
+static struct stress_shared *shared;
+
+struct stress_thread {
+    pthread_t thread;
+    unsigned int index;
+};
+
+static uint32_t next_rng(uint32_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static size_t parse_list(const char *arg, unsigned int *list, size_t max) {
+    char *copy = strdup(arg), *tok, *save;
+    size_t n = 0;
+
+    for (tok = strtok_r(copy, ",:", &save); tok && n < max; tok = strtok_r(NULL, ",:", &save))
+        list[n++] = strtoul(tok, NULL, 0);
+    free(copy);
+    return n;
+}
+
+static int write_stub_signals(const char *dir) {
+    char path[256];
+    unsigned int ch;
+    FILE *f;
+
+    for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++) {
+        snprintf(path, sizeof(path), "%s/ain%u", dir, ch);
+        f = fopen(path, "w");
+        if (!f)
+            return -errno;
+        fprintf(f, "0 %u 0 0 %u\n", (ch + 1) * STRESS_LEVEL_UV, STRESS_NOISE_UV);
+        if (fclose(f))
+            return -errno;
+    }
+    return 0;
+}
+
+static void client_check(struct stress_client *c, unsigned int channel, int16_t value) {
+    c->samples++;
+    if (channel >= ADS1115_NUM_CHANNELS || abs(value - params.expected[channel]) > params.tolerance)
+        c->mismatches++;
+}
+
+static void client_error(struct stress_client *c, int ret) {
+    if (!c->errors++)
+        c->first_error = -ret;
+}
+
+static void client_latency(struct stress_client *c, int op, uint64_t ns) {
+    if (c->nlat[op] < STRESS_LAT_MAX)
+        c->lat[op][c->nlat[op]++] = ns;
+}
+
+// Random non-empty subset of the channels under test
+static uint32_t random_mask(uint32_t *rng) {
+    uint32_t mask;
+
+    do
+        mask = next_rng(rng) & params.channel_mask;
+    while (!mask);
+    return mask;
+}
+
+static unsigned int random_channel(uint32_t *rng) {
+    unsigned int k = next_rng(rng) % __builtin_popcount(params.channel_mask), ch;
+
+    for (ch = 0;; ch++)
+        if ((params.channel_mask & (1u << ch)) && !k--)
+            return ch;
+}
+
+// Start a stream, take stream_samples samples and stop. The latency is the
+// time to the first sample, what a client feels when the sampler is shared.
+static void client_stream(struct ads1115_dev *dev, struct stress_client *c, uint32_t *rng) {
+    struct ads1115_stream_config cfg = { .channel_mask = random_mask(rng), .data_rate = params.data_rate };
+    struct ads1115_sample buf[64];
+    unsigned int got = 0;
+    uint64_t start = ads1115_now_ns();
+    uint16_t next_seq = 0;
+    ssize_t n, i;
+    int ret;
+
+    ret = ads1115_stream_start(dev, &cfg);
+    if (ret < 0) {
+        client_error(c, ret);
+        return;
+    }
+    while (got < params.stream_samples && !shared->stop) {
+        n = ads1115_stream_read(dev, buf, 64);
+        if (n == -EINTR || n == -EAGAIN)
+            continue;
+        if (n <= 0) {
+            if (n < 0)
+                client_error(c, n);
+            break;
+        }
+        if (!got)
+            client_latency(c, STRESS_STREAM, ads1115_now_ns() - start);
+        for (i = 0; i < n; i++) {
+            if (got + i && buf[i].seq != next_seq)
+                c->drops += (uint16_t)(buf[i].seq - next_seq);
+            next_seq = buf[i].seq + 1;
+            if (!(cfg.channel_mask & (1u << buf[i].channel)))
+                client_check(c, ADS1115_NUM_CHANNELS, buf[i].value);
+            else
+                client_check(c, buf[i].channel, buf[i].value);
+        }
+        got += n;
+    }
+    ret = ads1115_stream_stop(dev);
+    if (ret < 0)
+        client_error(c, ret);
+    c->ops[STRESS_STREAM]++;
+}
+
+static void client_run(unsigned int index) {
+    struct stress_client *c = &shared->clients[index];
+    const char *path = params.devices[index % params.num_devices];
+    unsigned int total = 0, pick, op, ch;
+    int16_t values[ADS1115_NUM_CHANNELS];
+    struct ads1115_dev *dev;
+    uint32_t rng = 0x9e3779b9 * (index + 1), mask;
+    uint64_t t;
+    int ret;
+
+    for (op = 0; op < STRESS_NUM_OPS; op++)
+        total += params.weights[op];
+
+    dev = ads1115_open_chrdev(path);
+    if (!dev)
+        client_error(c, -errno);
+    __atomic_add_fetch(&shared->ready, 1, __ATOMIC_SEQ_CST);
+    while (!__atomic_load_n(&shared->go, __ATOMIC_ACQUIRE))
+        usleep(100);
+    if (!dev)
+        return;
+
+    while (!__atomic_load_n(&shared->stop, __ATOMIC_ACQUIRE)) {
+        pick = next_rng(&rng) % total;
+        for (op = 0; pick >= params.weights[op]; op++)
+            pick -= params.weights[op];
+
+        switch (op) {
+        case STRESS_SINGLE:
+            ch = random_channel(&rng);
+            t = ads1115_now_ns();
+            ret = ads1115_read_channel(dev, ch, &values[0]);
+            if (ret < 0) {
+                client_error(c, ret);
+                break;
+            }
+            client_latency(c, op, ads1115_now_ns() - t);
+            client_check(c, ch, values[0]);
+            c->ops[op]++;
+            break;
+        case STRESS_SCAN:
+            mask = random_mask(&rng);
+            t = ads1115_now_ns();
+            ret = ads1115_scan(dev, mask, values);
+            if (ret < 0) {
+                client_error(c, ret);
+                break;
+            }
+            client_latency(c, op, ads1115_now_ns() - t);
+            for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++)
+                if (mask & (1u << ch))
+                    client_check(c, ch, values[ch]);
+            c->ops[op]++;
+            break;
+        default:
+            client_stream(dev, c, &rng);
+            break;
+        }
+    }
+    ads1115_close(dev);
+}
+
+static void *client_thread(void *arg) {
+    client_run(((struct stress_thread *)arg)->index);
+    return NULL;
+}
+
+struct stress_round {
+    unsigned long long ops;
+    unsigned long long samples;
+    unsigned long long mismatches;
+    unsigned long long errors;
+    unsigned long long drops;
+    int first_error;
+    double ops_per_s;
+    double samples_per_s;
+    double jain;    // Jain's fairness index of the ops per client, 1 is perfectly fair
+    double min_max; // Ops of the slowest client over the fastest
+    struct ads1115_lat_summary lat[STRESS_NUM_OPS];
+};
+
+static int run_round(unsigned int n, double seconds, int threads, uint64_t *lat_pool,
+                     struct stress_round *r) {
+    struct stress_thread th[STRESS_MAX_CLIENTS];
+    pid_t pids[STRESS_MAX_CLIENTS];
+    unsigned long long ops, min_ops = ~0ull, max_ops = 0;
+    double sum = 0, sum_sq = 0, elapsed;
+    uint64_t *merged, t0;
+    unsigned int i, op;
+    size_t total;
+
+    memset(shared, 0, sizeof(*shared));
+    for (i = 0; i < n; i++)
+        for (op = 0; op < STRESS_NUM_OPS; op++)
+            shared->clients[i].lat[op] = lat_pool + ((size_t)i * STRESS_NUM_OPS + op) * STRESS_LAT_MAX;
+
+    for (i = 0; i < n; i++) {
+        if (threads) {
+            th[i].index = i;
+            if (pthread_create(&th[i].thread, NULL, client_thread, &th[i]))
+                return -EAGAIN;
+        } else {
+            pids[i] = fork();
+            if (pids[i] < 0)
+                return -errno;
+            if (!pids[i]) {
+                client_run(i);
+                _exit(0);
+            }
+        }
+    }
+    while (__atomic_load_n(&shared->ready, __ATOMIC_ACQUIRE) < (int)n)
+        usleep(1000);
+    t0 = ads1115_now_ns();
+    __atomic_store_n(&shared->go, 1, __ATOMIC_RELEASE);
+    usleep(seconds * 1e6);
+    __atomic_store_n(&shared->stop, 1, __ATOMIC_RELEASE);
+    for (i = 0; i < n; i++) {
+        if (threads)
+            pthread_join(th[i].thread, NULL);
+        else
+            waitpid(pids[i], NULL, 0);
+    }
+    elapsed = (ads1115_now_ns() - t0) / 1e9;
+
+    memset(r, 0, sizeof(*r));
+    for (i = 0; i < n; i++) {
+        struct stress_client *c = &shared->clients[i];
+
+        for (ops = 0, op = 0; op < STRESS_NUM_OPS; op++)
+            ops += c->ops[op];
+        r->ops += ops;
+        r->samples += c->samples;
+        r->mismatches += c->mismatches;
+        r->drops += c->drops;
+        if (c->errors && !r->errors)
+            r->first_error = c->first_error;
+        r->errors += c->errors;
+        sum += ops;
+        sum_sq += (double)ops * ops;
+        if (ops < min_ops)
+            min_ops = ops;
+        if (ops > max_ops)
+            max_ops = ops;
+    }
+    r->ops_per_s = r->ops / elapsed;
+    r->samples_per_s = r->samples / elapsed;
+    r->jain = sum_sq > 0 ? sum * sum / (n * sum_sq) : 0;
+    r->min_max = max_ops ? (double)min_ops / max_ops : 0;
+
+    // Latencies of all clients together per operation
+    merged = malloc((size_t)n * STRESS_LAT_MAX * sizeof(*merged));
+    if (!merged)
+        return -ENOMEM;
+    for (op = 0; op < STRESS_NUM_OPS; op++) {
+        for (total = 0, i = 0; i < n; i++) {
+            memcpy(merged + total, shared->clients[i].lat[op],
+                   shared->clients[i].nlat[op] * sizeof(*merged));
+            total += shared->clients[i].nlat[op];
+        }
+        ads1115_lat_summarize(merged, total, &r->lat[op]);
+    }
+    free(merged);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -d path       Driver device, repeat for more (default /dev/ads1115)\n"
+            "  -n list       Client counts to sweep (default 1,2,4,8,16)\n"
+            "  -t seconds    Length of each round (default 2)\n"
+            "  -T            Clients are threads instead of processes\n"
+            "  -c mask       Channels to use (default 0xf)\n"
+            "  -r rate       DR code of the streams (default %d)\n"
+            "  -w weights    single:scan:stream operation mix (default 4:2:1)\n"
+            "  -k samples    Samples per stream (default 64)\n"
+            "  -s dir        Set channel-distinct levels on a stub chip, repeatable\n"
+            "                (default " STRESS_STUB_DIR ")\n"
+            "  -e codes      Expected code per channel instead, e.g. 4800,9600,14400,19200\n"
+            "  -g pga        PGA code the driver converts at (default %d)\n"
+            "  -E tolerance  Codes a value may differ from its channel's level (default 1000)\n",
+            prog, ADS1115_DR_MAX, ADS1115_PGA_DEFAULT);
+}
+
+int main(int argc, char **argv) {
+    unsigned int counts[STRESS_MAX_LIST] = { 1, 2, 4, 8, 16 }, codes[ADS1115_NUM_CHANNELS];
+    const char *stubs[STRESS_MAX_DEVICES] = { NULL };
+    unsigned int num_stubs = 0, pga = ADS1115_PGA_DEFAULT, i, ch, op, max_n = 0;
+    size_t num_counts = 5;
+    struct stress_round r;
+    double seconds = 2;
+    uint64_t *lat_pool;
+    int opt, threads = 0, have_codes = 0, ret, status = 0;
+
+    params.tolerance = 1000;
+    while ((opt = getopt(argc, argv, "d:n:t:Tc:r:w:k:s:e:g:E:h")) != -1) {
+        switch (opt) {
+        case 'd':
+            if (params.num_devices < STRESS_MAX_DEVICES)
+                params.devices[params.num_devices++] = optarg;
+            break;
+        case 'n': num_counts = parse_list(optarg, counts, STRESS_MAX_LIST); break;
+        case 't': seconds = strtod(optarg, NULL); break;
+        case 'T': threads = 1; break;
+        case 'c': params.channel_mask = strtoul(optarg, NULL, 0); break;
+        case 'r': params.data_rate = strtoul(optarg, NULL, 0); break;
+        case 'w':
+            if (parse_list(optarg, params.weights, STRESS_NUM_OPS) != STRESS_NUM_OPS) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'k': params.stream_samples = strtoul(optarg, NULL, 0); break;
+        case 's':
+            if (num_stubs < STRESS_MAX_DEVICES)
+                stubs[num_stubs++] = optarg;
+            break;
+        case 'e': have_codes = parse_list(optarg, codes, ADS1115_NUM_CHANNELS) == ADS1115_NUM_CHANNELS; break;
+        case 'g': pga = strtoul(optarg, NULL, 0); break;
+        case 'E': params.tolerance = strtol(optarg, NULL, 0); break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    for (i = 0; i < num_counts; i++)
+        if (counts[i] > max_n)
+            max_n = counts[i];
+    params.channel_mask &= (1u << ADS1115_NUM_CHANNELS) - 1;
+    if (!num_counts || !max_n || max_n > STRESS_MAX_CLIENTS || !params.channel_mask ||
+        params.data_rate > ADS1115_DR_MAX || pga > ADS1115_PGA_MAX ||
+        !(params.weights[0] + params.weights[1] + params.weights[2])) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (!params.num_devices)
+        params.devices[params.num_devices++] = "/dev/ads1115";
+
+    if (have_codes) {
+        for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++)
+            params.expected[ch] = (int16_t)codes[ch];
+    } else {
+        if (!num_stubs)
+            stubs[num_stubs++] = STRESS_STUB_DIR;
+        for (i = 0; i < num_stubs; i++) {
+            ret = write_stub_signals(stubs[i]);
+            if (ret < 0) {
+                fprintf(stderr, "Failed to set the inputs of %s: %s (give the levels with -e)\n",
+                        stubs[i], strerror(-ret));
+                return EXIT_FAILURE;
+            }
+        }
+        for (ch = 0; ch < ADS1115_NUM_CHANNELS; ch++) {
+            params.expected[ch] = (int64_t)(ch + 1) * STRESS_LEVEL_UV * 32768 / fsr_uv[pga];
+            if (params.expected[ch] > 32767)
+                params.expected[ch] = 32767;
+        }
+    }
+
+    shared = mmap(NULL, sizeof(*shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    lat_pool = mmap(NULL, (size_t)max_n * STRESS_NUM_OPS * STRESS_LAT_MAX * sizeof(*lat_pool),
+                    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED || lat_pool == MAP_FAILED) {
+        perror("Failed to map the shared results");
+        return EXIT_FAILURE;
+    }
+
+    printf("%-7s %9s %10s %8s %6s %6s %6s %7s", "clients", "ops/s", "samples/s", "mismatch",
+           "errors", "jain", "minmax", "drops");
+    for (op = 0; op < STRESS_NUM_OPS; op++)
+        printf(" %8s_p50 %8s_p99 %8s_max", op_names[op], op_names[op], op_names[op]);
+    printf("\n");
+
+    for (i = 0; i < num_counts; i++) {
+        if (!counts[i])
+            continue;
+        ret = run_round(counts[i], seconds, threads, lat_pool, &r);
+        if (ret < 0) {
+            fprintf(stderr, "Failed to start %u clients: %s\n", counts[i], strerror(-ret));
+            return EXIT_FAILURE;
+        }
+        printf("%-7u %9.0f %10.0f %8llu %6llu %6.3f %6.3f %7llu", counts[i], r.ops_per_s,
+               r.samples_per_s, r.mismatches, r.errors, r.jain, r.min_max, r.drops);
+        for (op = 0; op < STRESS_NUM_OPS; op++)
+            printf(" %12.0f %12.0f %12.0f", r.lat[op].p50_us, r.lat[op].p99_us, r.lat[op].max_us);
+        printf("\n");
+        if (r.errors)
+            fprintf(stderr, "%u clients: %llu failed calls, first: %s\n", counts[i], r.errors,
+                    strerror(r.first_error));
+        if (r.mismatches || r.errors)
+            status = EXIT_FAILURE;
+        fflush(stdout);
+    }
+    return status;
+}
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include "ads1115_tsfile.h"
+
+// Range queries on ads1115_tsfile.h recordings. Prints the samples of one
+// channel between two times as CSV, reading only the blocks that overlap
+// the range, or with -l the recorded config and a per-channel summary of
+// the index. Times are HH:MM[:SS] wall clock on the day of the first
+// sample, +seconds from the first sample, or raw CLOCK_MONOTONIC ns.
+
+#define TSQUERY_CHUNK 1024
+
+// Earliest timestamp in the file, the reference for relative times
+static uint64_t first_sample_ns(const struct ads1115_ts_index_entry *idx, size_t entries) {
+    uint64_t first = UINT64_MAX;
+    size_t i;
+
+    for (i = 0; i < entries; i++)
+        if (idx[i].first_ns < first)
+            first = idx[i].first_ns;
+    return entries ? first : 0;
+}
+
+static int parse_time(const char *arg, const struct ads1115_ts_header *hdr, uint64_t first_ns,
+                      uint64_t *ns) {
+    unsigned int hh, mm, ss = 0;
+    struct tm tm;
+    time_t t;
+
+    if (arg[0] == '+') {
+        *ns = first_ns + (uint64_t)(strtod(arg + 1, NULL) * 1e9);
+        return 0;
+    }
+    if (sscanf(arg, "%u:%u:%u", &hh, &mm, &ss) >= 2) {
+        t = (first_ns + hdr->realtime_offset_ns) / 1000000000;
+        localtime_r(&t, &tm);
+        tm.tm_hour = hh;
+        tm.tm_min = mm;
+        tm.tm_sec = ss;
+        tm.tm_isdst = -1;
+        t = mktime(&tm);
+        if (t == (time_t)-1 || (int64_t)t * 1000000000 < hdr->realtime_offset_ns)
+            return -EINVAL;
+        *ns = (int64_t)t * 1000000000 - hdr->realtime_offset_ns;
+        return 0;
+    }
+    *ns = strtoull(arg, NULL, 0);
+    return 0;
+}
+
+static void list(const struct ads1115_ts_reader *r) {
+    const struct ads1115_ts_header *hdr = ads1115_ts_info(r);
+    const struct ads1115_ts_index_entry *idx;
+    unsigned long long samples;
+    size_t entries, i, j, blocks;
+    unsigned int d, ch;
+
+    idx = ads1115_ts_index(r, &entries);
+    printf("%u devices, %u samples per block, %zu blocks\n",
+           hdr->num_devices, hdr->block_samples, entries);
+    for (d = 0; d < hdr->num_devices; d++)
+        printf("device %u: channel_mask 0x%x data_rate %u\n", d,
+               hdr->devices[d].channel_mask, hdr->devices[d].data_rate);
+
+    printf("%-6s %-7s %8s %10s %16s %16s\n", "device", "channel", "blocks", "samples", "first_s", "last_s");
+    for (i = 0; i < entries; i = j) {
+        d = idx[i].device;
+        ch = idx[i].channel;
+        samples = 0;
+        for (j = i; j < entries && idx[j].device == d && idx[j].channel == ch; j++)
+            samples += idx[j].count;
+        blocks = j - i;
+        printf("%-6u %-7u %8zu %10llu %16.3f %16.3f\n", d, ch, blocks, samples,
+               idx[i].first_ns / 1e9, idx[j - 1].last_ns / 1e9);
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] file\n"
+            "  -D device     Device index (default 0)\n"
+            "  -c channel    AIN index (default 0)\n"
+            "  -s time       Start of the range (default the first sample)\n"
+            "  -e time       End of the range, inclusive (default the last sample)\n"
+            "  -l            Print the recorded config and index summary instead\n"
+            "Times are HH:MM[:SS], +seconds from the first sample, or CLOCK_MONOTONIC ns\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *start = NULL, *end = NULL;
+    const struct ads1115_ts_index_entry *idx, *seek_at;
+    struct ads1115_sample buf[TSQUERY_CHUNK];
+    struct ads1115_ts_cursor cur;
+    struct ads1115_ts_reader *r;
+    unsigned int device = 0, channel = 0;
+    unsigned long long total = 0;
+    uint64_t first, from_ns = 0, to_ns = UINT64_MAX;
+    size_t entries, blocks, i;
+    int opt, do_list = 0, ret;
+    ssize_t n;
+
+    while ((opt = getopt(argc, argv, "D:c:s:e:lh")) != -1) {
+        switch (opt) {
+        case 'D': device = strtoul(optarg, NULL, 0); break;
+        case 'c': channel = strtoul(optarg, NULL, 0); break;
+        case 's': start = optarg; break;
+        case 'e': end = optarg; break;
+        case 'l': do_list = 1; break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    r = ads1115_ts_open(argv[optind]);
+    if (!r) {
+        fprintf(stderr, "Failed to open %s: %s\n", argv[optind], strerror(errno));
+        return EXIT_FAILURE;
+    }
+    if (do_list) {
+        list(r);
+        ads1115_ts_release(r);
+        return 0;
+    }
+
+    idx = ads1115_ts_index(r, &entries);
+    first = first_sample_ns(idx, entries);
+    if ((start && parse_time(start, ads1115_ts_info(r), first, &from_ns) < 0) ||
+        (end && parse_time(end, ads1115_ts_info(r), first, &to_ns) < 0)) {
+        fprintf(stderr, "Invalid time\n");
+        ads1115_ts_release(r);
+        return EXIT_FAILURE;
+    }
+    ret = ads1115_ts_seek(r, device, channel, from_ns, to_ns, &cur);
+    if (ret < 0) {
+        fprintf(stderr, "Invalid query: %s\n", strerror(-ret));
+        ads1115_ts_release(r);
+        return EXIT_FAILURE;
+    }
+
+    seek_at = cur.next;
+    printf("timestamp_ns,channel,value,flags,seq\n");
+    while ((n = ads1115_ts_read(r, &cur, buf, TSQUERY_CHUNK)) > 0) {
+        for (i = 0; i < (size_t)n; i++)
+            printf("%llu,%u,%d,%u,%u\n", (unsigned long long)buf[i].timestamp_ns,
+                   buf[i].channel, buf[i].value, buf[i].flags, buf[i].seq);
+        total += n;
+    }
+    // Blocks the query mapped in, the rest of the file was never touched
+    for (blocks = 0; seek_at + blocks < idx + entries && seek_at[blocks].device == device &&
+         seek_at[blocks].channel == channel && seek_at[blocks].first_ns <= to_ns; blocks++)
+        ;
+    fprintf(stderr, "%llu samples from %zu of %zu blocks\n", total, blocks, entries);
+    ads1115_ts_release(r);
+    return 0;
+}